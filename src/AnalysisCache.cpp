@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "AnalysisCache.hpp"
+
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+
+namespace
+{
+    const char* const extension = ".swsc";
+    const char* const lockName = ".lock";
+
+    // a temporary file this old belongs to a writer that died
+    const std::time_t abandonedAge = 60 * 60;
+
+    // the directory is scanned at least this often, for the entries other processes stored
+    const std::size_t storesPerEviction = 256;
+
+    const std::uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    const std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    const std::uint64_t prime3 = 0x165667B19E3779F9ull;
+
+    std::uint64_t rotateLeft(std::uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    std::uint64_t mix(std::uint64_t accumulator, std::uint64_t value)
+    {
+        return rotateLeft(accumulator + value * prime2, 31) * prime1;
+    }
+
+    std::uint64_t readWord(const unsigned char* bytes)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+
+    bool endsWith(const std::string& text, const std::string& end)
+    {
+        return text.size() >= end.size() && text.compare(text.size() - end.size(), end.size(), end) == 0;
+    }
+
+    struct Entry
+    {
+        std::string   path;
+        std::uint64_t size;
+        std::time_t   lastUse;
+    };
+}
+
+
+/**
+ * \param directory   Where the entries are kept, created by open() if it doesn't exist
+ * \param maximumSize The size of all entries in bytes, beyond it the least recently used are removed
+ */
+AnalysisCache::AnalysisCache(std::string directory, std::uint64_t maximumSize) :
+    m_directory(std::move(directory)),
+    m_maximumSize(maximumSize),
+    m_nextTemporary(0),
+    m_approximateSize(0),
+    m_storesSinceEviction(0)
+{
+
+}
+
+
+/**
+ * \brief Creates the directory if necessary and measures the entries already in it.
+ *
+ * \return Whether the cache can be used
+ */
+bool AnalysisCache::open()
+{
+    if (::mkdir(m_directory.c_str(), 0777) != 0 && errno != EEXIST)
+    {
+        std::cerr << "Could not create the cache directory \"" << m_directory << "\"." << std::endl;
+        return false;
+    }
+
+    evict();
+
+    return true;
+}
+
+
+/**
+ * \brief Loads the score of key and marks it as used.
+ *
+ * \return Whether there was a valid entry, a broken one is treated as missing
+ */
+bool AnalysisCache::load(const std::string& key, SineWaveScore& score) const
+{
+    const std::string path = m_directory + "/" + key + extension;
+
+    // a missing entry is the normal case, so don't let loadFromFile() complain about it
+    if (::access(path.c_str(), R_OK) != 0)
+        return false;
+
+    if (!score.loadFromFile(path))
+        return false;
+
+    // the modification time is the time of the last use, an entry evicted in the meantime just stays missing
+    ::utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+
+    return true;
+}
+
+
+/**
+ * \brief Stores the score of key, replacing an entry with the same key, and evicts the
+ *        least recently used entries if the cache grew too large.
+ *
+ * \return Whether the entry was written
+ */
+bool AnalysisCache::store(const std::string& key, const SineWaveScore& score)
+{
+    // the name is unique among all processes and threads, so no writer touches another ones file
+    std::ostringstream temporary;
+    temporary << m_directory << "/" << key << ".tmp." << ::getpid() << "." << m_nextTemporary++;
+
+    const std::string path = m_directory + "/" + key + extension;
+
+    if (!score.saveToFile(temporary.str()) || std::rename(temporary.str().c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.str().c_str());
+        std::cerr << "Could not write the cache entry \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    const std::uint64_t entrySize = ::stat(path.c_str(), &status) == 0 ? status.st_size : 0;
+
+    // a replaced entry is counted twice, the next scan corrects it
+    if ((m_approximateSize += entrySize) > m_maximumSize || ++m_storesSinceEviction >= storesPerEviction)
+        evict();
+
+    return true;
+}
+
+
+/**
+ * \brief A fast 64 bit hash, it reads 32 bytes per step into four independent lanes.
+ *        Not cryptographic, it only has to tell different recordings apart.
+ */
+std::uint64_t AnalysisCache::hash(const void* data, std::size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = bytes + size;
+
+    std::uint64_t lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+
+    for (; end - bytes >= 32; bytes += 32)
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+            lanes[i] = mix(lanes[i], readWord(bytes + 8 * i));
+    }
+
+    std::uint64_t result = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+    result += size;
+
+    for (; end - bytes >= 8; bytes += 8)
+        result = rotateLeft(result ^ mix(0, readWord(bytes)), 27) * prime1 + prime3;
+
+    for (; bytes < end; ++bytes)
+        result = rotateLeft(result ^ (*bytes * prime3), 11) * prime1;
+
+    // spread every input bit over the whole result
+    result ^= result >> 33;
+    result *= prime2;
+    result ^= result >> 29;
+    result *= prime3;
+    result ^= result >> 32;
+
+    return result;
+}
+
+
+/**
+ * \brief The name of the entry of one channel, it contains everything the analysis depends on.
+ *
+ * \param samplesHash      hash() of the samples of all channels
+ * \param numberOfChannels How many channels the samples have
+ * \param channel          The analysed channel
+ */
+std::string AnalysisCache::key(std::uint64_t samplesHash, std::size_t numberOfChannels, std::size_t channel,
+                               std::size_t sampleRate, std::size_t FFTSize, std::size_t hopSize)
+{
+    // the window and the FFT are fixed, they are part of the key so a change doesn't reuse old entries
+    std::ostringstream key;
+    key << std::hex << samplesHash << std::dec
+        << "-" << channel << "of" << numberOfChannels
+        << "-" << sampleRate << "-" << FFTSize << "-" << hopSize
+        << "-hann-simplefft-v" << SineWaveScore::version;
+
+    return key.str();
+}
+
+
+/**
+ * \brief Measures the directory and, if it grew beyond its size, removes the least recently
+ *        used entries until it is at 90 % of it, so the next stores don't evict right away.
+ *        Only one process evicts at a time, the others skip it instead of waiting.
+ */
+void AnalysisCache::evict()
+{
+    const std::string lockPath = m_directory + "/" + lockName;
+
+    const int lock = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (lock < 0)
+        return;
+
+    if (::flock(lock, LOCK_EX | LOCK_NB) != 0)
+    {
+        ::close(lock);
+        return;
+    }
+
+    m_storesSinceEviction = 0;
+
+    DIR* directory = ::opendir(m_directory.c_str());
+    if (directory)
+    {
+        const std::time_t now = std::time(nullptr);
+
+        std::vector<Entry> entries;
+        std::uint64_t totalSize = 0;
+
+        while (const dirent* file = ::readdir(directory))
+        {
+            const std::string name = file->d_name;
+            const std::string path = m_directory + "/" + name;
+
+            struct stat status;
+            if (::stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode))
+                continue;
+
+            if (endsWith(name, extension))
+            {
+                entries.push_back( Entry{ path, static_cast<std::uint64_t>(status.st_size), status.st_mtime } );
+                totalSize += status.st_size;
+            }
+            else if (name.find(".tmp.") != std::string::npos && now - status.st_mtime > abandonedAge)
+            {
+                ::unlink(path.c_str());
+            }
+        }
+        ::closedir(directory);
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+
+        // a reader that already opened an entry keeps reading it after the unlink
+        if (totalSize > m_maximumSize)
+        {
+            const std::uint64_t lowWaterMark = m_maximumSize - m_maximumSize / 10;
+
+            for (const auto& entry: entries)
+            {
+                if (totalSize <= lowWaterMark)
+                    break;
+
+                ::unlink(entry.path.c_str());
+                totalSize -= entry.size;
+            }
+        }
+
+        m_approximateSize = totalSize;
+    }
+
+    ::flock(lock, LOCK_UN);
+    ::close(lock);
+}
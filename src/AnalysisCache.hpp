@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef ANALYSISCACHE_HPP
+#define ANALYSISCACHE_HPP
+
+#include <atomic>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "SineWaveScore.hpp"
+
+/*
+ * \brief An on-disk cache of sine wave scores, so a signal that was analysed before only needs
+ *        the synthesis. The entries are addressed by a hash of the samples and the analysis
+ *        parameters, the synthesis parameters don't matter.
+ *        Any number of threads and processes can share a directory: entries are written to a
+ *        temporary file and renamed into place, so a reader sees a whole entry or none. Reading
+ *        an entry touches it and the least recently used entries are removed when the directory
+ *        grows beyond its size, down to 90 % of it. The directory is not scanned on every store:
+ *        each instance adds up what it stored and only scans when that passes the size or every
+ *        256 stores, which catches what other processes stored. POSIX only.
+ */
+
+class AnalysisCache
+{
+public:
+    AnalysisCache(std::string directory, std::uint64_t maximumSize);
+
+    bool open();
+
+    bool load(const std::string& key, SineWaveScore& score) const;
+    bool store(const std::string& key, const SineWaveScore& score);
+
+    static std::uint64_t hash(const void* data, std::size_t size);
+    static std::string   key(std::uint64_t samplesHash, std::size_t numberOfChannels, std::size_t channel,
+                             std::size_t sampleRate, std::size_t FFTSize, std::size_t hopSize);
+
+
+private:
+    void evict();
+
+    std::string                 m_directory;
+    std::uint64_t               m_maximumSize;
+    std::atomic<std::size_t>    m_nextTemporary;
+    std::atomic<std::uint64_t>  m_approximateSize;        // the directory at the last eviction plus the stores since
+    std::atomic<std::size_t>    m_storesSinceEviction;
+};
+
+
+#endif // ANALYSISCACHE_HPP
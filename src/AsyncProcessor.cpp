@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "AsyncProcessor.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+
+namespace
+{
+    // how long the worker sleeps when there is no input
+    const std::chrono::microseconds idleTime(250);
+}
+
+
+/**
+ * \param sineWaveSpeech The synthesis to run, its sample rate has to be set already.
+ *                       It must not be used by anyone else while the processor exists.
+ * \param safetyMargin   The extra latency in samples the worker is allowed to fall behind
+ * \param maxBlockSize   The largest block process() will be called with
+ */
+AsyncProcessor::AsyncProcessor(SineWaveSpeech& sineWaveSpeech, std::size_t safetyMargin, std::size_t maxBlockSize) :
+    m_sineWaveSpeech(sineWaveSpeech),
+    m_safetyMargin(safetyMargin),
+    m_input(2 * (safetyMargin + maxBlockSize)),
+    m_output(2 * (safetyMargin + maxBlockSize)),
+    m_workBuffer(maxBlockSize),
+    m_lateSamples(0),
+    m_underruns(0),
+    m_running(true)
+{
+    // the safety margin is played as silence while the worker starts
+    std::vector<float> silence(m_safetyMargin, 0.f);
+    m_output.write(silence.data(), silence.size());
+
+    m_worker = std::thread(&AsyncProcessor::run, this);
+}
+
+
+AsyncProcessor::~AsyncProcessor()
+{
+    m_running = false;
+    m_worker.join();
+}
+
+
+/**
+ * \brief Hands a block to the worker and returns the output of an earlier one.
+ *        Wait-free, call it from the audio thread only.
+ */
+void AsyncProcessor::process(const float* in, float* out, std::size_t n)
+{
+    // input that doesn't fit will never produce output, so don't wait for it
+    const std::size_t dropped = n - m_input.write(in, n);
+    m_lateSamples -= std::min(m_lateSamples, dropped);
+
+    // samples that were replaced by silence are thrown away when they finally arrive
+    m_lateSamples -= m_output.skip(m_lateSamples);
+
+    const std::size_t available = m_output.read(out, n);
+    if (available < n)
+    {
+        std::fill(out + available, out + n, 0.f);
+        m_lateSamples += n - available;
+        ++m_underruns;
+    }
+}
+
+
+/**
+ * \brief The total delay between input and output in samples.
+ */
+std::size_t AsyncProcessor::latency() const
+{
+    return m_sineWaveSpeech.latency() + m_safetyMargin;
+}
+
+
+/**
+ * \brief How often the audio thread had to play silence because the worker was too late.
+ */
+std::size_t AsyncProcessor::underruns() const
+{
+    return m_underruns;
+}
+
+
+void AsyncProcessor::run()
+{
+    while (m_running)
+    {
+        const std::size_t n = std::min(m_input.readAvailable(), m_output.writeAvailable());
+        if (n == 0)
+        {
+            std::this_thread::sleep_for(idleTime);
+            continue;
+        }
+
+        const std::size_t chunk = m_input.read(m_workBuffer.data(), std::min(n, m_workBuffer.size()));
+
+        m_sineWaveSpeech.processBlock(m_workBuffer.data(), m_workBuffer.data(), chunk);
+
+        m_output.write(m_workBuffer.data(), chunk);
+    }
+}
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef ASYNCPROCESSOR_HPP
+#define ASYNCPROCESSOR_HPP
+
+#include <vector>
+#include <atomic>
+#include <thread>
+
+#include "SineWaveSpeech.hpp"
+#include "SPSCRing.hpp"
+
+/*
+ * \brief Runs the analysis and synthesis of a SineWaveSpeech on a worker thread.
+ *        The audio thread only copies its input into a ring buffer and its output out of
+ *        another one, so a slow frame can't make it miss its deadline. The output is delayed
+ *        by a safety margin, which is how late the worker may be before the audio thread
+ *        runs out of samples. If it does, silence is played and the late samples are dropped
+ *        once they arrive, so the latency stays the same.
+ */
+
+class AsyncProcessor
+{
+public:
+    AsyncProcessor(SineWaveSpeech& sineWaveSpeech, std::size_t safetyMargin, std::size_t maxBlockSize);
+    ~AsyncProcessor();
+
+    void        process(const float* in, float* out, std::size_t n);
+    std::size_t latency() const;
+    std::size_t underruns() const;
+
+
+private:
+    void run();
+
+    SineWaveSpeech&           m_sineWaveSpeech;
+    std::size_t               m_safetyMargin;
+    SPSCRing<float>           m_input;
+    SPSCRing<float>           m_output;
+    std::vector<float>        m_workBuffer;
+    std::size_t               m_lateSamples;
+    std::atomic<std::size_t>  m_underruns;
+    std::atomic<bool>         m_running;
+    std::thread               m_worker;
+};
+
+
+#endif // ASYNCPROCESSOR_HPP
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef AUDIOHOST_HPP
+#define AUDIOHOST_HPP
+
+#include <functional>
+#include <cstddef>
+
+/*
+ * \brief A source and sink of audio periods, e.g. a JACK client or a simulated sound card.
+ *        The host calls the callback once per period with planar buffers of every channel,
+ *        the live engine doesn't need to know which backend drives it.
+ */
+
+class AudioHost
+{
+public:
+    // in and out hold one pointer to n samples per channel
+    typedef std::function<void(const float* const* in, float* const* out, std::size_t n)> Callback;
+
+    virtual ~AudioHost() {}
+
+    virtual std::size_t sampleRate() = 0;
+    virtual std::size_t numberOfChannels() = 0;
+    virtual std::size_t maxPeriodSize() = 0;
+
+    // how often the backend couldn't deliver or play a period in time, callable from any thread
+    virtual std::size_t xruns() = 0;
+
+    // starts calling the callback, see the host for whether this returns right away
+    virtual void start(Callback callback) = 0;
+    virtual void stop() = 0;
+};
+
+
+#endif // AUDIOHOST_HPP
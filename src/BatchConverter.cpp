@@ -0,0 +1,410 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+
+#include "AnalysisCache.hpp"
+#include "MultichannelSineWaveSpeech.hpp"
+#include "StreamingConverter.hpp"
+#include "WavFile.hpp"
+#include "WorkerPool.hpp"
+
+#include <glob.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    struct Job
+    {
+        std::string input;
+        std::string output;
+    };
+
+    struct Options
+    {
+        std::size_t                FFTSize;
+        std::size_t                hopSize;
+        std::size_t                glideSteps;
+        std::size_t                pipelineDepth;
+        bool                       streaming;
+        SineWaveSpeech::Parameters parameters;
+        AnalysisCache*             analysisCache;
+    };
+
+    struct Result
+    {
+        bool   success;
+        bool   cached;          // the analysis came from the cache
+        double duration;        // seconds of audio
+        double processingTime;  // seconds
+    };
+
+
+    // expands a pattern like "recordings/*.wav", a pattern without matches is taken as a file name
+    std::vector<std::string> expand(const std::string& pattern)
+    {
+        std::vector<std::string> paths;
+
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0)
+        {
+            for (std::size_t i = 0; i < matches.gl_pathc; ++i)
+                paths.push_back(matches.gl_pathv[i]);
+        }
+        else
+        {
+            paths.push_back(pattern);
+        }
+        globfree(&matches);
+
+        return paths;
+    }
+
+    std::string fileName(const std::string& path)
+    {
+        const auto slash = path.find_last_of('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    Result convert(const Job& job, const Options& options, WorkerPool& workerPool)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        Result result = { false, false, 0.0, 0.0 };
+
+        if (options.streaming)
+        {
+            // loading, converting and saving are interleaved, so the time includes the file access
+            StreamingConverter converter(options.FFTSize, options.hopSize, options.glideSteps);
+            converter.parameters(options.parameters);
+
+            const auto start = Clock::now();
+            result.success = converter.convert(job.input, job.output);
+            result.processingTime = std::chrono::duration<double>(Clock::now() - start).count();
+            result.duration = converter.sampleRate() > 0 ? static_cast<double>(converter.numberOfFrames()) / converter.sampleRate() : 0.0;
+
+            return result;
+        }
+
+        WavFile input;
+        if (!input.loadFromFile(job.input))
+            return result;
+
+        const auto start = Clock::now();
+
+        // the channels and the shards of a long file are nested tasks, threads without a file of their own steal them
+        MultichannelSineWaveSpeech sineWaveSpeech(input.numberOfChannels(), options.FFTSize, options.hopSize, options.glideSteps, true);
+        sineWaveSpeech.parameters(options.parameters);
+        sineWaveSpeech.workerPool(&workerPool);
+        sineWaveSpeech.pipelineDepth(options.pipelineDepth);
+
+        const auto layout = MultichannelSineWaveSpeech::Layout::Interleaved;
+        std::vector<float> samples;
+
+        if (options.analysisCache)
+        {
+            // one entry per channel, the analysis only runs if any of them is missing
+            const std::uint64_t samplesHash = AnalysisCache::hash(input.samples().data(), input.samples().size() * sizeof(float));
+
+            std::vector<std::string> keys;
+            std::vector<SineWaveScore> scores(input.numberOfChannels());
+            result.cached = true;
+            for (std::size_t c = 0; c < input.numberOfChannels(); ++c)
+            {
+                keys.push_back( AnalysisCache::key(samplesHash, input.numberOfChannels(), c, input.sampleRate(), options.FFTSize, options.hopSize) );
+                result.cached = result.cached && options.analysisCache->load(keys[c], scores[c])
+                             && scores[c].FFTSize() == options.FFTSize && scores[c].hopSize() == options.hopSize
+                             && scores[c].sampleRate() == input.sampleRate();
+            }
+
+            if (!result.cached)
+            {
+                scores = sineWaveSpeech.analyse(input.samples(), layout, input.sampleRate());
+                for (std::size_t c = 0; c < input.numberOfChannels(); ++c)
+                    options.analysisCache->store(keys[c], scores[c]);
+            }
+
+            samples = sineWaveSpeech.generateSineWaveSpeech(scores, layout, input.sampleRate());
+
+            // a score that doesn't fit has been reported, the file fails instead of being written silent
+            if (samples.empty() && !input.samples().empty())
+                return result;
+        }
+        else
+        {
+            samples = sineWaveSpeech.generateSineWaveSpeech(input.samples(), layout, input.sampleRate(), 1);
+        }
+
+        // drop the zero padding, so the output is as long as the input
+        samples.resize(input.samples().size());
+
+        result.processingTime = std::chrono::duration<double>(Clock::now() - start).count();
+        result.duration = static_cast<double>(input.numberOfFrames()) / input.sampleRate();
+        result.success = WavFile(std::move(samples), input.numberOfChannels(), input.sampleRate()).saveToFile(job.output);
+
+        return result;
+    }
+
+    void printUsage(const char* name)
+    {
+        std::cerr << "usage: " << name << " -o output directory [options] input.wav... | \"pattern*.wav\"...\n"
+                  << "       " << name << " -l list file [options]    (one \"input.wav output.wav\" per line)\n"
+                  << "options:\n"
+                  << "  -n FFT size (512)            -h hop size (FFT size / 2)     -g glide samples (50)\n"
+                  << "  -w sine|sawtooth|triangle    -s tone|ifft synthesis         -c cutoff frequency in Hz (3000)\n"
+                  << "  -a amplitude scale (1.414)   -j threads (every core)\n"
+                  << "  -q frames queued between analysis and synthesis, 0 analyses the whole file first (0)\n"
+                  << "  -b stream every file in chunks, memory stays the same for any length\n"
+                  << "  -k cache directory, analyses are kept there and reused by later runs (not with -b)\n"
+                  << "  -m cache size in MB (1024)" << std::endl;
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options;
+    options.FFTSize = 512;
+    options.hopSize = 0;
+    options.glideSteps = 50;
+    options.pipelineDepth = 0;
+    options.streaming = false;
+    options.analysisCache = nullptr;
+    options.parameters = { 3000.f, std::sqrt(2.f), 50, 0, SineWaveSpeech::Synthesis::ToneGenerator };
+
+    std::string outputDirectory;
+    std::string listPath;
+    std::size_t numberOfThreads = 0;
+    std::string cacheDirectory;
+    std::uint64_t cacheSize = 1024;
+
+    int option;
+    while ((option = getopt(argc, argv, "o:l:n:h:g:w:s:c:a:j:q:bk:m:")) != -1)
+    {
+        switch (option) {
+        case 'o':
+            outputDirectory = optarg;
+            break;
+        case 'l':
+            listPath = optarg;
+            break;
+        case 'n':
+            options.FFTSize = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'h':
+            options.hopSize = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'g':
+            options.glideSteps = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'w':
+        {
+            const std::string waveform = optarg;
+            if (waveform == "sine")
+                options.parameters.toneGenerator = 0;
+            else if (waveform == "sawtooth")
+                options.parameters.toneGenerator = 1;
+            else if (waveform == "triangle")
+                options.parameters.toneGenerator = 2;
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            break;
+        }
+        case 's':
+            if (std::string(optarg) == "ifft")
+                options.parameters.synthesis = SineWaveSpeech::Synthesis::InverseFFT;
+            else if (std::string(optarg) == "tone")
+                options.parameters.synthesis = SineWaveSpeech::Synthesis::ToneGenerator;
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'c':
+            options.parameters.cutoffFrequency = std::strtof(optarg, nullptr);
+            break;
+        case 'a':
+            options.parameters.amplitudeScale = std::strtof(optarg, nullptr);
+            break;
+        case 'j':
+            numberOfThreads = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'q':
+            options.pipelineDepth = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'b':
+            options.streaming = true;
+            break;
+        case 'k':
+            cacheDirectory = optarg;
+            break;
+        case 'm':
+            cacheSize = std::strtoull(optarg, nullptr, 10);
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // a streamed file is never analysed as a whole, so there is no score to cache
+    if (options.streaming && !cacheDirectory.empty())
+    {
+        std::cerr << "The cache (-k) can't be used with streaming (-b)." << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // the analysis cache stores the bins in 16 bits
+    if (options.FFTSize < 16 || options.FFTSize > SineWaveScore::maximumFFTSize || (options.FFTSize & (options.FFTSize - 1)))
+    {
+        std::cerr << "The FFT size has to be a power of 2 between 16 and " << SineWaveScore::maximumFFTSize << "." << std::endl;
+        return 1;
+    }
+    if (options.hopSize == 0)
+        options.hopSize = options.FFTSize / 2;
+    if (options.hopSize < options.FFTSize / 8 || options.hopSize > options.FFTSize)
+    {
+        std::cerr << "The hop size has to be between FFT size / 8 and FFT size." << std::endl;
+        return 1;
+    }
+    options.parameters.glideSteps = options.glideSteps;
+
+    std::unique_ptr<AnalysisCache> analysisCache;
+    if (!cacheDirectory.empty())
+    {
+        analysisCache = std::make_unique<AnalysisCache>(cacheDirectory, cacheSize * 1024 * 1024);
+        if (!analysisCache->open())
+            return 1;
+        options.analysisCache = analysisCache.get();
+    }
+
+    // collect the jobs from the list file or the arguments
+    std::vector<Job> jobs;
+    if (!listPath.empty())
+    {
+        std::ifstream list(listPath);
+        if (!list)
+        {
+            std::cerr << "Could not open \"" << listPath << "\"." << std::endl;
+            return 1;
+        }
+
+        std::string line;
+        while (std::getline(list, line))
+        {
+            std::istringstream fields(line);
+            Job job;
+            if (fields >> job.input >> job.output)
+                jobs.push_back(job);
+        }
+    }
+    else
+    {
+        if (outputDirectory.empty() || optind == argc)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        for (int i = optind; i < argc; ++i)
+        {
+            for (const auto& input: expand(argv[i]))
+                jobs.push_back( Job{ input, outputDirectory + "/" + fileName(input) } );
+        }
+    }
+
+    // two jobs writing the same file would race, keep the first one
+    std::set<std::string> outputs;
+    for (auto job = jobs.begin(); job != jobs.end(); )
+    {
+        if (outputs.insert(job->output).second)
+        {
+            ++job;
+        }
+        else
+        {
+            std::cerr << "Skipping " << job->input << ", " << job->output << " is already written by another job." << std::endl;
+            job = jobs.erase(job);
+        }
+    }
+
+    WorkerPool workerPool(numberOfThreads);
+    std::vector<Result> results(jobs.size());
+    std::mutex printMutex;
+
+    auto task = [&](std::size_t i)
+    {
+        results[i] = convert(jobs[i], options, workerPool);
+
+        std::lock_guard<std::mutex> lock(printMutex);
+        if (results[i].success)
+            std::cout << jobs[i].input << " -> " << jobs[i].output << ": "
+                      << std::fixed << std::setprecision(2) << results[i].duration << " s in "
+                      << std::setprecision(3) << results[i].processingTime << " s, real-time factor "
+                      << std::setprecision(4) << (results[i].duration > 0.0 ? results[i].processingTime / results[i].duration : 0.0)
+                      << (results[i].cached ? " (cached analysis)" : "") << std::endl;
+        else
+            std::cerr << jobs[i].input << " failed." << std::endl;
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // every file is a task, a long one is split into shards, so one file can use every thread
+    // while a batch of short files keeps them busy with whole files
+    workerPool.run(jobs.size(), task);
+
+    const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t failures = 0;
+    double duration = 0.0;
+    double processingTime = 0.0;
+    for (const auto& result: results)
+    {
+        failures += result.success ? 0 : 1;
+        duration += result.duration;
+        processingTime += result.processingTime;
+    }
+
+    // the aggregate factor includes loading and saving and profits from the parallel files
+    std::cout << jobs.size() - failures << " of " << jobs.size() << " files, "
+              << std::fixed << std::setprecision(2) << duration << " s of audio in " << std::setprecision(3) << wallTime
+              << " s on " << workerPool.numberOfThreads() << " threads, real-time factor "
+              << std::setprecision(4) << (duration > 0.0 ? wallTime / duration : 0.0)
+              << " (" << (duration > 0.0 ? processingTime / duration : 0.0) << " summed over the threads)" << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
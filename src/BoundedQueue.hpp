@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef BOUNDEDQUEUE_HPP
+#define BOUNDEDQUEUE_HPP
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+/*
+ * \brief A blocking queue with a fixed capacity between one producer and one consumer.
+ *        push() waits while the queue is full, pop() waits while it is empty, so the faster
+ *        side is held back and the memory never grows beyond the capacity.
+ *        Unlike SPSCRing it blocks, so it is only meant for offline work.
+ */
+
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(std::size_t capacity) :
+        m_buffer(capacity),
+        m_readPosition(0),
+        m_size(0),
+        m_closed(false)
+    {
+
+    }
+
+    // waits for a free slot. Only call from the producer thread
+    void push(const T& element)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_size < m_buffer.size(); });
+
+        m_buffer[(m_readPosition + m_size) % m_buffer.size()] = element;
+        ++m_size;
+
+        lock.unlock();
+        m_notEmpty.notify_one();
+    }
+
+    // the producer is done, pop() returns false once the queue is empty
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_notEmpty.notify_one();
+    }
+
+    // waits for an element, returns false if the queue is closed and empty. Only call from the consumer thread
+    bool pop(T& element)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_size > 0 || m_closed; });
+
+        if (m_size == 0)
+            return false;
+
+        element = m_buffer[m_readPosition];
+        m_readPosition = (m_readPosition + 1) % m_buffer.size();
+        --m_size;
+
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+
+private:
+    std::vector<T>           m_buffer;
+    std::size_t              m_readPosition;
+    std::size_t              m_size;
+    bool                     m_closed;
+    std::mutex               m_mutex;
+    std::condition_variable  m_notFull;
+    std::condition_variable  m_notEmpty;
+};
+
+#endif // BOUNDEDQUEUE_HPP
@@ -19,12 +19,17 @@
 ////////////////////////////////////////////////////////////
 
 
-#include "SineWaveSpeech.hpp"
+#include "LiveEngine.hpp"
+#include "NullAudioHost.hpp"
+#include "WavFile.hpp"
+#include "Telemetry.hpp"
 
 #include <jackaudioio.hpp>
 
 #include <stdlib.h>
 #include <algorithm>
+#include <string>
+#include <vector>
 #include <iostream>
 #include <unistd.h>
 
@@ -66,12 +71,11 @@ char getch(void)
 }
 
 
-class CaptianJack: public JackCpp::AudioIO {
+/* The largest JACK period the live engine is prepared for */
+static const std::size_t maxPeriodSize = 4096;
 
-private:
-    std::vector<float> m_in;
-    std::size_t m_fs;
 
+class CaptianJack: public AudioHost, private JackCpp::AudioIO {
 
 public:
     /// Jack Audio Callback Function
@@ -81,60 +85,284 @@ public:
                               // A vector of pointers to each output port.
                               audioBufVector outBufs)
     {
-       /* for(int i = 0; i  < nframes; ++i)
-        {
-            inBufs[0][i] *= 5.f;
-        }*/
+        m_callback(inBufs.data(), outBufs.data(), nframes);
 
-        auto halfNFrames = nframes / 2;
-        std::copy_n(m_in.begin() + halfNFrames, halfNFrames, m_in.begin());
-
-        std::copy_n(inBufs[0], nframes, m_in.begin() + halfNFrames);
+        return 0;
+    }
 
-        auto out = m_sineGenerator.generateSineWaveSpeech(m_in, m_fs);
+    /// Constructor
+    CaptianJack(std::size_t numberOfChannels) :
+        JackCpp::AudioIO("captian_jack", numberOfChannels, numberOfChannels),
+        m_numberOfChannels(numberOfChannels)
+    {
+        reserveInPorts(numberOfChannels);
+        reserveOutPorts(std::max<std::size_t>(2, numberOfChannels));
+    }
 
-        for(int i = 0; i  < nframes; ++i)
+    ~CaptianJack()
+    {
+        for (unsigned int c = 0; c < m_numberOfChannels; ++c)
         {
-            outBufs[0][i] = out[i];
+            disconnectInPort(c);	// Disconnecting ports.
+            disconnectOutPort(c);
         }
+        close();	// stop client.
+    }
 
-        return 0;
+    std::size_t sampleRate() override
+    {
+        return getSampleRate();
     }
 
-    /// Constructor
-    CaptianJack() :
-        JackCpp::AudioIO("captian_jack", 1,1),
-        m_sineGenerator(512, false),
-        m_in (static_cast<std::size_t>(getBufferSize()) * 1.5f, 0.f),
-        m_fs (getSampleRate())
+    std::size_t numberOfChannels() override
     {
-        reserveInPorts(1);
-        reserveOutPorts(2);
+        return m_numberOfChannels;
+    }
+
+    /// The period can change while running, so this is the largest one we accept
+    std::size_t maxPeriodSize() override
+    {
+        return ::maxPeriodSize;
+    }
+
+    std::size_t xruns() override
+    {
+        return getXRunCount();
+    }
+
+    /// Activates the client, returns right away. The callback runs on the JACK thread
+    void start(Callback callback) override
+    {
+        m_callback = std::move(callback);
 
         /// activate the client
-        start();
+        JackCpp::AudioIO::start();
 
-        /// connect input
-        connectFromPhysical(0,0);
+        /// connect every channel to the physical port with the same number
+        for (unsigned int c = 0; c < m_numberOfChannels; ++c)
+        {
+            connectFromPhysical(c,c);
+            connectToPhysical(c,c);
+        }
 
-        /// connect ports to stereo ports
-        connectToPhysical(0,0);		// connects this client out port 0 to physical destination port 0
-        connectToPhysical(0,1);		// connects this client out port 1 to physical destination port 1
+        /// a mono input is played on both stereo ports
+        if (m_numberOfChannels == 1)
+            connectToPhysical(0,1);		// connects this client out port 0 to physical destination port 1
     }
 
-    ~CaptianJack()
+    void stop() override
     {
-        disconnectInPort(0);	// Disconnecting ports.
-        disconnectOutPort(0);
-        close();	// stop client.
+        JackCpp::AudioIO::stop();
     }
 
+    using JackCpp::AudioIO::inPorts;
+    using JackCpp::AudioIO::outPorts;
+    using JackCpp::AudioIO::getInputPortName;
+    using JackCpp::AudioIO::getOutputPortName;
 
-    SineWaveSpeech m_sineGenerator;
+
+private:
+    std::size_t m_numberOfChannels;
+    Callback    m_callback;
 };
 
+
+namespace
+{
+    /* Parses a comma separated list of period sizes */
+    std::vector<std::size_t> parsePeriodSizes(const char* list)
+    {
+        std::vector<std::size_t> periodSizes;
+        char* end = nullptr;
+        for (const char* p = list; *p; p = *end ? end + 1 : end)
+        {
+            periodSizes.push_back(std::strtoul(p, &end, 10));
+            if (end == p)
+                return {};
+        }
+        return periodSizes;
+    }
+
+    /* Logs the timing of the engine every interval from a thread of its own, nothing if the interval is 0 */
+    std::unique_ptr<TelemetryPublisher> publishTelemetry(LiveEngine& engine, AudioHost& host, double interval, const std::string& statsPath)
+    {
+        if (interval <= 0.0)
+            return nullptr;
+
+        return std::make_unique<TelemetryPublisher>(engine.telemetry(),
+                                                    std::chrono::milliseconds(static_cast<std::int64_t>(1000 * interval)),
+                                                    statsPath,
+                                                    [&host] { return host.xruns(); },
+                                                    [&engine] { return engine.underruns(); });
+    }
+
+    /* Plays a WAV file through the engine on a simulated sound card and reports the timing */
+    int runNullHost(const std::string& inputPath, const std::string& outputPath, const std::vector<std::size_t>& periodSizes,
+                    double deadlineScale, bool realTime, std::size_t FFTSize, std::size_t hopSize, std::size_t safetyMargin,
+                    double telemetryInterval, const std::string& statsPath)
+    {
+        WavFile input;
+        if (!input.loadFromFile(inputPath))
+            return 1;
+
+        NullAudioHost host(input, periodSizes, deadlineScale, realTime);
+        LiveEngine engine(host.numberOfChannels(), host.sampleRate(), FFTSize, hopSize, safetyMargin, host.maxPeriodSize(), deadlineScale);
+
+        std::cout << "latency: " << engine.latency() << " samples ("
+                  << 1000.0 * engine.latency() / host.sampleRate() << " ms)" << std::endl;
+
+        auto publisher = publishTelemetry(engine, host, telemetryInterval, statsPath);
+
+        host.start([&engine](const float* const* in, float* const* out, std::size_t n)
+                   {
+                       engine.process(in, out, n);
+                   });
+
+        if (publisher)
+            publisher->publish();
+
+        const auto& report = host.report();
+        for (std::size_t i = 0; i < report.periods.size(); ++i)
+        {
+            const auto& period = report.periods[i];
+            if (period.computeTime > period.deadline)
+                std::cout << "period " << i << " (" << period.size << " samples) missed its deadline: "
+                          << 1e6 * period.computeTime << " us of " << 1e6 * period.deadline << " us" << std::endl;
+        }
+
+        std::cout << report.periods.size() << " periods, "
+                  << report.deadlineMisses << " deadline misses, "
+                  << engine.underruns() << " worker underruns, "
+                  << "compute time mean " << 1e6 * report.meanComputeTime << " us, "
+                  << "max " << 1e6 * report.maxComputeTime << " us, "
+                  << "max load " << 100.0 * report.maxLoad << " %" << std::endl;
+
+        if (!outputPath.empty() && !WavFile(host.output(), host.numberOfChannels(), host.sampleRate()).saveToFile(outputPath))
+            return 1;
+
+        return report.deadlineMisses == 0 ? 0 : 2;
+    }
+}
+
+
 int main(int argc, char *argv[]) {
-    CaptianJack cj;
+    std::size_t FFTSize = 512;
+    std::size_t hopSize = 0;
+    std::size_t safetyMargin = 0;
+    std::size_t numberOfChannels = 1;
+    std::string driver = "jack";
+    std::string inputPath;
+    std::string outputPath;
+    std::vector<std::size_t> periodSizes = { 256 };
+    double deadlineScale = 1.0;
+    bool realTime = false;
+    double telemetryInterval = 0.0;
+    std::string statsPath;
+
+    int option;
+    while ((option = getopt(argc, argv, "c:n:h:m:d:i:o:p:s:rt:j:")) != -1)
+    {
+        switch (option) {
+        case 't':
+            telemetryInterval = std::strtod(optarg, nullptr);
+            break;
+        case 'j':
+            statsPath = optarg;
+            break;
+        case 'd':
+            driver = optarg;
+            break;
+        case 'i':
+            inputPath = optarg;
+            break;
+        case 'o':
+            outputPath = optarg;
+            break;
+        case 'p':
+            periodSizes = parsePeriodSizes(optarg);
+            break;
+        case 's':
+            deadlineScale = std::strtod(optarg, nullptr);
+            break;
+        case 'r':
+            realTime = true;
+            break;
+        case 'c':
+            numberOfChannels = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'n':
+            FFTSize = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'h':
+            hopSize = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'm':
+            safetyMargin = std::strtoul(optarg, nullptr, 10);
+            break;
+        default:
+            std::cerr << "usage: " << argv[0] << " [-c channels] [-n FFT size] [-h hop size] [-m worker thread safety margin]\n"
+                      << "                 [-t telemetry interval in seconds] [-j telemetry stats file]\n"
+                      << "       " << argv[0] << " -d null -i input.wav [-o output.wav] [-p period sizes, e.g. 256,64]\n"
+                      << "                 [-s deadline as fraction of the period] [-r real-time pacing] [-n] [-h] [-m] [-t] [-j]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (numberOfChannels < 1)
+    {
+        std::cerr << "There has to be at least 1 channel." << std::endl;
+        return 1;
+    }
+    if (FFTSize < 16 || (FFTSize & (FFTSize - 1)))
+    {
+        std::cerr << "The FFT size has to be a power of 2 and at least 16." << std::endl;
+        return 1;
+    }
+    if (hopSize == 0)
+        hopSize = FFTSize / 2;
+    if (hopSize < FFTSize / 8 || hopSize > FFTSize)
+    {
+        std::cerr << "The hop size has to be between FFT size / 8 and FFT size." << std::endl;
+        return 1;
+    }
+
+    if (driver == "null")
+    {
+        if (inputPath.empty())
+        {
+            std::cerr << "The null driver needs an input file (-i)." << std::endl;
+            return 1;
+        }
+        if (periodSizes.empty() || std::find(periodSizes.begin(), periodSizes.end(), 0) != periodSizes.end()
+            || *std::max_element(periodSizes.begin(), periodSizes.end()) > maxPeriodSize)
+        {
+            std::cerr << "The period sizes have to be between 1 and " << maxPeriodSize << "." << std::endl;
+            return 1;
+        }
+        if (deadlineScale <= 0.0)
+        {
+            std::cerr << "The deadline has to be larger than 0." << std::endl;
+            return 1;
+        }
+        return runNullHost(inputPath, outputPath, periodSizes, deadlineScale, realTime, FFTSize, hopSize, safetyMargin,
+                           telemetryInterval, statsPath);
+    }
+    if (driver != "jack")
+    {
+        std::cerr << "Unknown driver \"" << driver << "\", use jack or null." << std::endl;
+        return 1;
+    }
+
+    CaptianJack cj(numberOfChannels);
+    LiveEngine engine(numberOfChannels, cj.sampleRate(), FFTSize, hopSize, safetyMargin, cj.maxPeriodSize());
+    auto& sineGenerator = engine.sineWaveSpeech();
+
+    cj.start([&engine](const float* const* in, float* const* out, std::size_t n)
+             {
+                 engine.process(in, out, n);
+             });
+
+    auto publisher = publishTelemetry(engine, cj, telemetryInterval, statsPath);
 
     ///print names
     std::cout << "outport names:" << std::endl;
@@ -148,14 +376,59 @@ int main(int argc, char *argv[]) {
         std::cout << "\t" << cj.getInputPortName(i) << std::endl;
     }
 
+    std::cout << "latency: " << engine.latency() << " samples ("
+              << 1000.0 * engine.latency() / cj.sampleRate() << " ms)" << std::endl;
+
+    std::cout << "keys: q quit, w next tone generator, f toggle inverse FFT, "
+              << "c/C cutoff down/up, a/A amplitude down/up, g/G glide shorter/longer" << std::endl;
+
     while (true)
     {
+        // the audio thread picks up every change at the start of its next block
+        auto parameters = sineGenerator.parameters();
+
         auto c = getch();
         switch (c) {
         case 'q':
+            cj.stop();      // the engine goes away before the client
             return 0;
         case 'w':
-            cj.m_sineGenerator.nextToneGenerator();
+            sineGenerator.nextToneGenerator();
+            break;
+        case 'f':
+            sineGenerator.synthesis(parameters.synthesis == SineWaveSpeech::Synthesis::InverseFFT
+                                         ? SineWaveSpeech::Synthesis::ToneGenerator
+                                         : SineWaveSpeech::Synthesis::InverseFFT);
+            break;
+        case 'c':
+            parameters.cutoffFrequency = std::max(250.f, parameters.cutoffFrequency - 250.f);
+            sineGenerator.parameters(parameters);
+            std::cout << "cutoff: " << parameters.cutoffFrequency << " Hz" << std::endl;
+            break;
+        case 'C':
+            parameters.cutoffFrequency += 250.f;
+            sineGenerator.parameters(parameters);
+            std::cout << "cutoff: " << parameters.cutoffFrequency << " Hz" << std::endl;
+            break;
+        case 'a':
+            parameters.amplitudeScale /= 1.25f;
+            sineGenerator.parameters(parameters);
+            std::cout << "amplitude scale: " << parameters.amplitudeScale << std::endl;
+            break;
+        case 'A':
+            parameters.amplitudeScale *= 1.25f;
+            sineGenerator.parameters(parameters);
+            std::cout << "amplitude scale: " << parameters.amplitudeScale << std::endl;
+            break;
+        case 'g':
+            parameters.glideSteps /= 2;
+            sineGenerator.parameters(parameters);
+            std::cout << "glide: " << sineGenerator.parameters().glideSteps << " samples" << std::endl;
+            break;
+        case 'G':
+            parameters.glideSteps *= 2;
+            sineGenerator.parameters(parameters);
+            std::cout << "glide: " << sineGenerator.parameters().glideSteps << " samples" << std::endl;
             break;
         default:
             std::cout << c << std::endl;
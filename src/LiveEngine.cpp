@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "LiveEngine.hpp"
+
+#include <chrono>
+
+
+/**
+ * \param numberOfChannels The number of channels of every period
+ * \param sampleRate       The sample rate of the host
+ * \param FFTSize          The analysis size, independent of the period size
+ * \param hopSize          The distance between two frames in samples
+ * \param safetyMargin     > 0 runs the synthesis on worker threads, which may fall behind by that many samples
+ * \param maxPeriodSize    The largest period the host will call process() with
+ * \param deadlineScale    The deadline of a callback as a fraction of its period, as given to the NullAudioHost
+ */
+LiveEngine::LiveEngine(std::size_t numberOfChannels, std::size_t sampleRate, std::size_t FFTSize, std::size_t hopSize,
+                       std::size_t safetyMargin, std::size_t maxPeriodSize, double deadlineScale) :
+    m_sampleRate(sampleRate),
+    m_deadlineScale(deadlineScale),
+    m_sineWaveSpeech(numberOfChannels, FFTSize, hopSize, 50, false)
+{
+    m_sineWaveSpeech.sampleRate(sampleRate);
+    m_sineWaveSpeech.telemetry(&m_telemetry);
+
+    if (safetyMargin > 0)
+    {
+        for (std::size_t c = 0; c < numberOfChannels; ++c)
+            m_asyncProcessors.push_back( std::make_unique<AsyncProcessor>(m_sineWaveSpeech.channel(c), safetyMargin, maxPeriodSize) );
+    }
+}
+
+
+/**
+ * \brief Analyses and synthesizes the hops completed by this period, all channels in one pass.
+ *        Doesn't allocate or lock, call it from the audio thread. The time it takes is recorded
+ *        in the telemetry, longer than the deadline share of the period is a deadline miss.
+ */
+void LiveEngine::process(const float* const* in, float* const* out, std::size_t n)
+{
+    typedef std::chrono::steady_clock Clock;
+    const auto start = Clock::now();
+
+    if (m_asyncProcessors.empty())
+    {
+        m_sineWaveSpeech.processBlock(in, out, n);
+    }
+    else
+    {
+        for (std::size_t c = 0; c < m_asyncProcessors.size(); ++c)
+            m_asyncProcessors[c]->process(in[c], out[c], n);
+    }
+
+    const std::chrono::nanoseconds deadline(static_cast<std::int64_t>(1e9 * m_deadlineScale * n / m_sampleRate));
+    m_telemetry.recordCallback(Clock::now() - start, deadline);
+}
+
+
+/**
+ * \brief The delay between input and output in samples, the same for every period size.
+ */
+std::size_t LiveEngine::latency() const
+{
+    return m_asyncProcessors.empty() ? m_sineWaveSpeech.latency() : m_asyncProcessors[0]->latency();
+}
+
+
+/**
+ * \brief How often a worker thread was too late, summed over all channels.
+ */
+std::size_t LiveEngine::underruns() const
+{
+    std::size_t underruns = 0;
+    for (const auto& asyncProcessor: m_asyncProcessors)
+        underruns += asyncProcessor->underruns();
+    return underruns;
+}
+
+
+MultichannelSineWaveSpeech& LiveEngine::sineWaveSpeech()
+{
+    return m_sineWaveSpeech;
+}
+
+
+/**
+ * \brief The callback and stage timing, read it from any thread.
+ */
+const Telemetry& LiveEngine::telemetry() const
+{
+    return m_telemetry;
+}
@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef LIVEENGINE_HPP
+#define LIVEENGINE_HPP
+
+#include <vector>
+#include <memory>
+
+#include "MultichannelSineWaveSpeech.hpp"
+#include "AsyncProcessor.hpp"
+#include "Telemetry.hpp"
+
+/*
+ * \brief The live sine wave speech of every channel, independent of the audio backend.
+ *        process() is the callback of an AudioHost. With a safety margin every channel
+ *        runs on its own worker thread, otherwise the callback does all the work.
+ */
+
+class LiveEngine
+{
+public:
+    LiveEngine(std::size_t numberOfChannels, std::size_t sampleRate, std::size_t FFTSize, std::size_t hopSize,
+               std::size_t safetyMargin, std::size_t maxPeriodSize, double deadlineScale = 1.0);
+
+    void        process(const float* const* in, float* const* out, std::size_t n);
+    std::size_t latency() const;
+    std::size_t underruns() const;
+
+    MultichannelSineWaveSpeech& sineWaveSpeech();
+    const Telemetry&            telemetry() const;
+
+
+private:
+    std::size_t                                   m_sampleRate;
+    double                                        m_deadlineScale;
+    Telemetry                                     m_telemetry;
+    MultichannelSineWaveSpeech                    m_sineWaveSpeech;
+    std::vector<std::unique_ptr<AsyncProcessor>>  m_asyncProcessors;
+};
+
+
+#endif // LIVEENGINE_HPP
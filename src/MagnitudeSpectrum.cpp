@@ -19,16 +19,20 @@
 ////////////////////////////////////////////////////////////
 
 #include "MagnitudeSpectrum.hpp"
+#include "PCM.hpp"
 
 #include "simple_fft/fft.hpp"
 
 #include <cmath>
+#include <limits>
 #include <numeric>
 #include <algorithm>
 #include <functional>
 #include <cassert>
 #include <complex>
 #include <iostream>
+#include <map>
+#include <mutex>
 
 namespace
 {
@@ -43,6 +47,24 @@ namespace
         }
         return window;
     }
+
+    // the window only depends on the size, so all spectra of a size share one
+    std::shared_ptr<const std::vector<float>> sharedHannWindow(std::size_t size)
+    {
+        static std::mutex                                                    windowMutex;
+        static std::map<std::size_t, std::weak_ptr<const std::vector<float>>> windows;
+
+        std::lock_guard<std::mutex> lock(windowMutex);
+
+        auto& cached = windows[size];
+        auto window = cached.lock();
+        if (!window)
+        {
+            window = std::make_shared<const std::vector<float>>(generateHannWindow(size));
+            cached = window;
+        }
+        return window;
+    }
 }
 
 
@@ -53,7 +75,8 @@ MagnitudeSpectrum::MagnitudeSpectrum(std::size_t FFTSize, Range spectrumRangeTyp
     m_fftResult(FFTSize),
     m_spectrumRangeType(spectrumRangeType),
     m_magnitudeVector(FFTSize / 2, 0.f),
-    m_window(generateHannWindow(FFTSize))
+    m_window(sharedHannWindow(FFTSize)),
+    m_windowedSamples(FFTSize)
 {
     // Bithack to check if FFTSize is a power of 2
     // http://www.graphics.stanford.edu/~seander/bithacks.html#DetermineIfPowerOf2
@@ -74,19 +97,51 @@ MagnitudeSpectrum::MagnitudeSpectrum(std::size_t FFTSize, Range spectrumRangeTyp
 }
 
 
-void MagnitudeSpectrum::process(std::vector<float> sampleChunck)
+/**
+ * \brief Calculates the magnitude spectrum of FFTSize samples. Doesn't allocate memory.
+ */
+void MagnitudeSpectrum::process(const std::vector<float>& sampleChunck)
 {
-    // haha wtf?!
-    m_window = generateHannWindow(m_FFTSize);
+    process(sampleChunck.data());
+}
+
 
+/**
+ * \brief Calculates the magnitude spectrum of the FFTSize samples starting at samples,
+ *        e.g. a frame in the middle of a signal without copying it first.
+ */
+void MagnitudeSpectrum::process(const float* samples)
+{
     // apply the window function
-    std::transform(sampleChunck.begin(), sampleChunck.end(), m_window.begin(), sampleChunck.begin(), std::multiplies<float>());
+    const float* window = m_window->data();
+    for (std::size_t i = 0; i < m_FFTSize; ++i)
+        m_windowedSamples[i] = samples[i] * window[i];
+
+    transform();
+}
+
+
+/**
+ * \brief Calculates the magnitude spectrum of FFTSize 16 bit samples, e.g. straight from a WAV file.
+ *        Converting and windowing is one pass, the result is the same as for the converted floats.
+ */
+void MagnitudeSpectrum::process(const std::int16_t* samples)
+{
+    const float* window = m_window->data();
+    for (std::size_t i = 0; i < m_FFTSize; ++i)
+        m_windowedSamples[i] = (samples[i] * PCM::int16Scale) * window[i];
+
+    transform();
+}
 
+
+void MagnitudeSpectrum::transform()
+{
     // do the FFT
-    //m_fft.process(sampleChunck.data());
+    //m_fft.process(m_windowedSamples.data());
 
     const char* error = nullptr;
-    if( !simple_fft::FFT(sampleChunck, m_fftResult, m_FFTSize, error) )
+    if( !simple_fft::FFT(m_windowedSamples, m_fftResult, m_FFTSize, error) )
         std::cout << error << std::endl;
 
     std::size_t startBin = 0;
@@ -104,8 +159,8 @@ void MagnitudeSpectrum::process(std::vector<float> sampleChunck)
         lastBin = 1;
     }
 
-    // calculate the magnitude spectrum
-    std::transform(m_fftResult.begin() + startBin, m_fftResult.end() - lastBin, m_magnitudeVector.begin(),
+    // calculate the magnitude spectrum, the bins above the nyquist mirror the ones below
+    std::transform(m_fftResult.begin() + startBin, m_fftResult.begin() + m_FFTSize / 2 + 1 - lastBin, m_magnitudeVector.begin(),
                    [] (std::complex<float> c)
                    {
                        return std::sqrt(c.real() * c.real() + c.imag() * c.imag());
@@ -23,6 +23,8 @@
 
 #include <vector>
 #include <complex>
+#include <memory>
+#include <cstdint>
 
 //#include "FFT.hpp"
 
@@ -43,20 +45,25 @@ public:
     
     MagnitudeSpectrum(std::size_t FFTSize, Range spectrumRangeType = Range::ExcludeDC_IncludeNyquist);
     
-    void                      process(std::vector<float> sampleChunck);
+    void                      process(const std::vector<float>& sampleChunck);
+    void                      process(const float* samples);
+    void                      process(const std::int16_t* samples);
     const std::vector<float>& getMagnitudeSpectrum() const;
     const std::vector<float>  getLogarithmicMagnitudeSpectrum();
     std::size_t               numberOfBins();
     
     
 private:
+    void transform();
+    
     //FFT                        m_fft;
     std::size_t                m_FFTSize;
     std::vector<std::complex<float>> m_fftResult;
     Range                      m_spectrumRangeType;
     std::vector<float>         m_magnitudeVector;
     std::vector<float>         m_logarithmicMagnitudeVector;
-    std::vector<float>   m_window;
+    std::shared_ptr<const std::vector<float>> m_window;    // shared by all spectra of the same size
+    std::vector<float>   m_windowedSamples;
 };
 
 
@@ -0,0 +1,434 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "MappedWav.hpp"
+#include "PCM.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+
+namespace
+{
+    const std::uint16_t formatExtensible = 0xFFFE;
+
+    const std::size_t headerSize = 44;
+
+    // WAV files are little endian, independent of the machine
+    std::uint32_t readLittleEndian(const unsigned char* bytes, std::size_t numberOfBytes)
+    {
+        std::uint32_t value = 0;
+        for (std::size_t i = 0; i < numberOfBytes; ++i)
+            value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+        return value;
+    }
+
+    void writeLittleEndian(unsigned char* bytes, std::uint32_t value, std::size_t numberOfBytes)
+    {
+        for (std::size_t i = 0; i < numberOfBytes; ++i)
+            bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+    }
+
+    bool isLittleEndian()
+    {
+        const std::uint16_t one = 1;
+        unsigned char firstByte;
+        std::memcpy(&firstByte, &one, 1);
+        return firstByte == 1;
+    }
+
+    // drops the pages of [begin, end) of a mapping from the memory of the process. The last page
+    // is kept if it continues after end, the next call drops it with the first one of its range
+    void releasePages(void* mapping, std::size_t begin, std::size_t end, bool writeBack)
+    {
+        const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        begin = begin / pageSize * pageSize;
+        end = end / pageSize * pageSize;
+
+        if (begin >= end)
+            return;
+
+        unsigned char* pages = static_cast<unsigned char*>(mapping) + begin;
+
+        // a shared mapping keeps its data when the pages are dropped, start writing them anyway
+        if (writeBack)
+            msync(pages, end - begin, MS_ASYNC);
+        madvise(pages, end - begin, MADV_DONTNEED);
+    }
+}
+
+
+MappedWavReader::MappedWavReader() :
+    m_mapping(nullptr),
+    m_mappingSize(0),
+    m_pcm(nullptr),
+    m_numberOfFrames(0),
+    m_numberOfChannels(0),
+    m_sampleRate(0),
+    m_format(0),
+    m_bytesPerSample(0)
+{
+
+}
+
+
+MappedWavReader::~MappedWavReader()
+{
+    close();
+}
+
+
+/**
+ * \brief Maps a WAV file and parses its header, a file that is already open is closed first.
+ *
+ * \return Whether the file could be read, the reason is printed if not
+ */
+bool MappedWavReader::open(const std::string& path)
+{
+    close();
+
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        std::cerr << "Could not open \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size < 12)
+    {
+        ::close(file);
+        std::cerr << "\"" << path << "\" is not a WAV file." << std::endl;
+        return false;
+    }
+
+    // the mapping stays valid after the file is closed
+    m_mappingSize = static_cast<std::size_t>(status.st_size);
+    m_mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+
+    if (m_mapping == MAP_FAILED)
+    {
+        m_mapping = nullptr;
+        std::cerr << "Could not map \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    // the samples are read front to back, let the kernel read ahead
+    madvise(m_mapping, m_mappingSize, MADV_SEQUENTIAL);
+
+    const unsigned char* data = static_cast<const unsigned char*>(m_mapping);
+    if (std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        close();
+        std::cerr << "\"" << path << "\" is not a WAV file." << std::endl;
+        return false;
+    }
+
+    std::size_t pcmSize = 0;
+
+    // walk the chunks, every chunk is padded to an even size
+    std::size_t position = 12;
+    while (position + 8 <= m_mappingSize)
+    {
+        const unsigned char* chunk = data + position;
+        const std::size_t chunkSize = std::min<std::size_t>(readLittleEndian(chunk + 4, 4), m_mappingSize - position - 8);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16)
+        {
+            m_format = readLittleEndian(chunk + 8, 2);
+            m_numberOfChannels = readLittleEndian(chunk + 10, 2);
+            m_sampleRate = readLittleEndian(chunk + 12, 4);
+            m_bytesPerSample = readLittleEndian(chunk + 22, 2) / 8;
+
+            // the actual format is the first two bytes of the sub format GUID
+            if (m_format == formatExtensible && chunkSize >= 26)
+                m_format = readLittleEndian(chunk + 32, 2);
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            m_pcm = chunk + 8;
+            pcmSize = chunkSize;
+        }
+
+        position += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    const bool supported = (m_format == PCM::formatInteger && m_bytesPerSample >= 2 && m_bytesPerSample <= 4)
+                        || (m_format == PCM::formatFloat && m_bytesPerSample == 4);
+    if (!supported || m_numberOfChannels == 0 || !m_pcm)
+    {
+        close();
+        std::cerr << "\"" << path << "\" has no supported PCM data (16, 24, 32 bit integer or 32 bit float)." << std::endl;
+        return false;
+    }
+
+    m_numberOfFrames = pcmSize / (m_bytesPerSample * m_numberOfChannels);
+
+    return true;
+}
+
+
+void MappedWavReader::close()
+{
+    if (m_mapping)
+        munmap(m_mapping, m_mappingSize);
+
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_pcm = nullptr;
+    m_numberOfFrames = 0;
+    m_numberOfChannels = 0;
+    m_sampleRate = 0;
+    m_format = 0;
+    m_bytesPerSample = 0;
+}
+
+
+std::size_t MappedWavReader::numberOfChannels() const
+{
+    return m_numberOfChannels;
+}
+
+
+std::size_t MappedWavReader::numberOfFrames() const
+{
+    return m_numberOfFrames;
+}
+
+
+std::size_t MappedWavReader::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+
+std::uint16_t MappedWavReader::format() const
+{
+    return m_format;
+}
+
+
+std::size_t MappedWavReader::bytesPerSample() const
+{
+    return m_bytesPerSample;
+}
+
+
+/**
+ * \brief The raw interleaved PCM payload in the format of the file, little endian.
+ */
+const unsigned char* MappedWavReader::pcm() const
+{
+    return m_pcm;
+}
+
+
+/**
+ * \brief The payload as interleaved 16 bit samples, without any conversion.
+ *        nullptr unless the file is 16 bit integer PCM and the machine is little endian.
+ */
+const std::int16_t* MappedWavReader::int16Samples() const
+{
+    // chunks start at even offsets of a page aligned mapping, so the samples are always aligned
+    if (m_format != PCM::formatInteger || m_bytesPerSample != 2 || !isLittleEndian())
+        return nullptr;
+
+    return reinterpret_cast<const std::int16_t*>(m_pcm);
+}
+
+
+/**
+ * \brief Decodes interleaved frames into floats in the range [-1, 1].
+ *
+ * \param samples Room for numberOfFrames * numberOfChannels() samples
+ */
+void MappedWavReader::readFrames(std::size_t firstFrame, std::size_t numberOfFrames, float* samples) const
+{
+    PCM::decode(m_pcm + firstFrame * m_numberOfChannels * m_bytesPerSample, m_format, m_bytesPerSample,
+                samples, numberOfFrames * m_numberOfChannels);
+}
+
+
+/**
+ * \brief Tells the kernel the frames won't be read again, so their pages stop counting towards
+ *        the memory of the process. They are read from the file again if they are accessed.
+ */
+void MappedWavReader::release(std::size_t firstFrame, std::size_t numberOfFrames) const
+{
+    const std::size_t frameSize = m_numberOfChannels * m_bytesPerSample;
+    const std::size_t offset = m_pcm - static_cast<const unsigned char*>(m_mapping);
+
+    releasePages(m_mapping, offset + firstFrame * frameSize, offset + (firstFrame + numberOfFrames) * frameSize, false);
+}
+
+
+
+MappedWavWriter::MappedWavWriter() :
+    m_mapping(nullptr),
+    m_mappingSize(0),
+    m_file(-1),
+    m_pcm(nullptr),
+    m_numberOfFrames(0),
+    m_numberOfChannels(0)
+{
+
+}
+
+
+MappedWavWriter::~MappedWavWriter()
+{
+    close();
+}
+
+
+/**
+ * \brief Creates a 16 bit PCM WAV file with room for numberOfFrames frames and maps it.
+ *        Frames that are never written stay silent.
+ *
+ * \return Whether the file could be created, the reason is printed if not
+ */
+bool MappedWavWriter::open(const std::string& path, std::size_t numberOfChannels, std::size_t sampleRate, std::size_t numberOfFrames)
+{
+    close();
+
+    const std::size_t dataSize = numberOfFrames * numberOfChannels * 2;
+    if (dataSize > 0xFFFFFFFFu - headerSize)
+    {
+        std::cerr << "\"" << path << "\" would be too large for a WAV file." << std::endl;
+        return false;
+    }
+
+    m_file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_file < 0)
+    {
+        std::cerr << "Could not create \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    // the blocks are reserved up front, so a full disk fails here instead of as a SIGBUS while writing
+    // through the mapping. Allocated and truncated files both read as zeros, there is no need to write the silence.
+    m_mappingSize = headerSize + dataSize;
+    int error = posix_fallocate(m_file, 0, static_cast<off_t>(m_mappingSize));
+    if (error == EOPNOTSUPP || error == EINVAL)
+        error = ftruncate(m_file, static_cast<off_t>(m_mappingSize)) == 0 ? 0 : errno;
+    if (error != 0)
+    {
+        close();
+        std::cerr << "Could not allocate \"" << path << "\": " << std::strerror(error) << std::endl;
+        return false;
+    }
+
+    m_mapping = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+    if (m_mapping == MAP_FAILED)
+    {
+        m_mapping = nullptr;
+        close();
+        std::cerr << "Could not map \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    unsigned char* header = static_cast<unsigned char*>(m_mapping);
+
+    std::memcpy(header, "RIFF", 4);
+    writeLittleEndian(header + 4, static_cast<std::uint32_t>(36 + dataSize), 4);
+    std::memcpy(header + 8, "WAVE", 4);
+
+    std::memcpy(header + 12, "fmt ", 4);
+    writeLittleEndian(header + 16, 16, 4);
+    writeLittleEndian(header + 20, PCM::formatInteger, 2);
+    writeLittleEndian(header + 22, static_cast<std::uint32_t>(numberOfChannels), 2);
+    writeLittleEndian(header + 24, static_cast<std::uint32_t>(sampleRate), 4);
+    writeLittleEndian(header + 28, static_cast<std::uint32_t>(sampleRate * numberOfChannels * 2), 4);   // bytes per second
+    writeLittleEndian(header + 32, static_cast<std::uint32_t>(numberOfChannels * 2), 2);                // bytes per frame
+    writeLittleEndian(header + 34, 16, 2);
+
+    std::memcpy(header + 36, "data", 4);
+    writeLittleEndian(header + 40, static_cast<std::uint32_t>(dataSize), 4);
+
+    m_pcm = header + headerSize;
+    m_numberOfFrames = numberOfFrames;
+    m_numberOfChannels = numberOfChannels;
+
+    return true;
+}
+
+
+/**
+ * \brief Writes the samples back and unmaps the file. The write back is waited for,
+ *        so an error writing the file shows up in the result.
+ *
+ * \return Whether a file was open and closed without an error
+ */
+bool MappedWavWriter::close()
+{
+    bool success = m_file >= 0;
+
+    if (m_mapping)
+    {
+        success = msync(m_mapping, m_mappingSize, MS_SYNC) == 0 && success;
+        success = munmap(m_mapping, m_mappingSize) == 0 && success;
+    }
+    if (m_file >= 0)
+        success = ::close(m_file) == 0 && success;
+
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_file = -1;
+    m_pcm = nullptr;
+    m_numberOfFrames = 0;
+    m_numberOfChannels = 0;
+
+    return success;
+}
+
+
+std::size_t MappedWavWriter::numberOfFrames() const
+{
+    return m_numberOfFrames;
+}
+
+
+/**
+ * \brief Encodes interleaved frames in the range [-1, 1] into the file, samples outside are clipped.
+ */
+void MappedWavWriter::writeFrames(std::size_t firstFrame, std::size_t numberOfFrames, const float* samples)
+{
+    PCM::encodeInt16(samples, m_pcm + firstFrame * m_numberOfChannels * 2, numberOfFrames * m_numberOfChannels);
+}
+
+
+/**
+ * \brief Hands the written frames over to the kernel, so their pages stop counting towards the
+ *        memory of the process. Their samples still end up in the file.
+ */
+void MappedWavWriter::release(std::size_t firstFrame, std::size_t numberOfFrames)
+{
+    const std::size_t frameSize = m_numberOfChannels * 2;
+
+    releasePages(m_mapping, headerSize + firstFrame * frameSize, headerSize + (firstFrame + numberOfFrames) * frameSize, true);
+}
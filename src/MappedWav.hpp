@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef MAPPEDWAV_HPP
+#define MAPPEDWAV_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * \brief Reads a WAV file through a memory mapping of the whole file.
+ *        Nothing is copied on open(), the PCM payload is a view into the mapping and the
+ *        pages are only read by the kernel when the samples are accessed.
+ *        Supports 16, 24 and 32 bit integer and 32 bit float PCM. POSIX only.
+ */
+
+class MappedWavReader
+{
+public:
+    MappedWavReader();
+    ~MappedWavReader();
+
+    MappedWavReader(const MappedWavReader&) = delete;
+    MappedWavReader& operator=(const MappedWavReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    std::size_t          numberOfChannels() const;
+    std::size_t          numberOfFrames() const;
+    std::size_t          sampleRate() const;
+    std::uint16_t        format() const;             // 1 integer, 3 float, as in the fmt chunk
+    std::size_t          bytesPerSample() const;
+
+    const unsigned char* pcm() const;
+    const std::int16_t*  int16Samples() const;
+    void                 readFrames(std::size_t firstFrame, std::size_t numberOfFrames, float* samples) const;
+    void                 release(std::size_t firstFrame, std::size_t numberOfFrames) const;
+
+
+private:
+    void*                 m_mapping;
+    std::size_t           m_mappingSize;
+    const unsigned char*  m_pcm;
+    std::size_t           m_numberOfFrames;
+    std::size_t           m_numberOfChannels;
+    std::size_t           m_sampleRate;
+    std::uint16_t         m_format;
+    std::size_t           m_bytesPerSample;
+};
+
+
+/*
+ * \brief Writes a 16 bit PCM WAV file of a known length through a memory mapping.
+ *        open() sizes the file and writes the header, the samples are then encoded
+ *        straight into the mapping, in any order and from any number of calls.
+ */
+
+class MappedWavWriter
+{
+public:
+    MappedWavWriter();
+    ~MappedWavWriter();
+
+    MappedWavWriter(const MappedWavWriter&) = delete;
+    MappedWavWriter& operator=(const MappedWavWriter&) = delete;
+
+    bool open(const std::string& path, std::size_t numberOfChannels, std::size_t sampleRate, std::size_t numberOfFrames);
+    bool close();
+
+    std::size_t   numberOfFrames() const;
+    void          writeFrames(std::size_t firstFrame, std::size_t numberOfFrames, const float* samples);
+    void          release(std::size_t firstFrame, std::size_t numberOfFrames);
+
+
+private:
+    void*          m_mapping;
+    std::size_t    m_mappingSize;
+    int            m_file;
+    unsigned char* m_pcm;
+    std::size_t    m_numberOfFrames;
+    std::size_t    m_numberOfChannels;
+};
+
+
+#endif // MAPPEDWAV_HPP
@@ -0,0 +1,443 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "MultichannelSineWaveSpeech.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cassert>
+
+
+namespace
+{
+    // interleaved blocks are split into chunks of this many samples per channel
+    const std::size_t interleavedChunkSize = 256;
+}
+
+
+/**
+ * \param numberOfChannels The number of channels of every buffer, at least 1
+ *
+ * The other arguments are the same as for SineWaveSpeech and apply to every channel.
+ */
+MultichannelSineWaveSpeech::MultichannelSineWaveSpeech(std::size_t numberOfChannels, std::size_t FFTSize, std::size_t hopSize, std::size_t glideSteps, bool zeroPadAtEnd) :
+    m_workerPool(nullptr),
+    m_channelSamples(interleavedChunkSize),
+    m_int16ChannelSamples(interleavedChunkSize)
+{
+    assert(numberOfChannels > 0 && "Argument \"numberOfChannels\" has to be at least 1!");
+
+    for (std::size_t i = 0; i < numberOfChannels; ++i)
+        m_channels.push_back( std::make_unique<SineWaveSpeech>(FFTSize, hopSize, glideSteps, zeroPadAtEnd) );
+}
+
+
+/**
+ * \brief Generates the sine wave speech of every channel.
+ *
+ * \param samples         The samples of all channels in the given layout, normalized in the range [-1, 1]
+ * \param layout          How the channels are arranged in samples, the output has the same layout
+ * \param sampleRate      The sample rate of the samples
+ * \param numberOfThreads How many channels are processed at the same time, 0 uses every core.
+ *                        Ignored with a workerPool(), then the channels and their shards are tasks of the pool.
+ *
+ * \return The sine wave speech of all channels in the range [-1, 1]
+ */
+std::vector<float> MultichannelSineWaveSpeech::generateSineWaveSpeech(const std::vector<float>& samples, Layout layout, std::size_t sampleRate, std::size_t numberOfThreads)
+{
+    return generate(samples, layout, sampleRate, numberOfThreads);
+}
+
+
+/**
+ * \brief Generates the sine wave speech of every channel of 16 bit samples, e.g. straight from a WAV file.
+ *        The output is the same as for the samples converted to floats by n / 32768.
+ */
+std::vector<float> MultichannelSineWaveSpeech::generateSineWaveSpeech(const std::vector<std::int16_t>& samples, Layout layout, std::size_t sampleRate, std::size_t numberOfThreads)
+{
+    return generate(samples, layout, sampleRate, numberOfThreads);
+}
+
+
+template<typename Sample>
+std::vector<float> MultichannelSineWaveSpeech::generate(const std::vector<Sample>& samples, Layout layout, std::size_t sampleRate, std::size_t numberOfThreads)
+{
+    const std::size_t numberOfChannels = m_channels.size();
+    assert(samples.size() % numberOfChannels == 0 && "Argument \"samples\" has to contain the same number of samples for every channel!");
+
+    // a single channel is the same in both layouts
+    if (numberOfChannels == 1)
+        layout = Layout::Planar;
+
+    const std::size_t length = samples.size() / numberOfChannels;
+    const std::size_t outputLength = m_channels[0]->outputSize(length);
+
+    std::vector<float> output;
+    std::vector<std::vector<float>> outputs(numberOfChannels);
+
+    // planar channels are read and written in place, interleaved ones are copied out and back in
+    std::function<void(std::size_t)> task;
+    if (layout == Layout::Planar)
+    {
+        output.resize(outputLength * numberOfChannels);
+        task = [&](std::size_t c)
+        {
+            m_channels[c]->generateSineWaveSpeech(samples.data() + c * length, length, sampleRate, output.data() + c * outputLength);
+        };
+    }
+    else
+    {
+        task = [&](std::size_t c)
+        {
+            const std::vector<Sample> channel = channelSamples(samples, layout, c);
+            outputs[c].resize(outputLength);
+            m_channels[c]->generateSineWaveSpeech(channel.data(), length, sampleRate, outputs[c].data());
+        };
+    }
+
+    if (m_workerPool)
+    {
+        forEachChannel(task);
+    }
+    else
+    {
+        // every worker takes the next channel that isn't done yet
+        std::atomic<std::size_t> nextChannel(0);
+        auto worker = [&]()
+        {
+            for (std::size_t c = nextChannel++; c < numberOfChannels; c = nextChannel++)
+                task(c);
+        };
+
+        if (numberOfThreads == 0)
+            numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+        numberOfThreads = std::min(numberOfThreads, numberOfChannels);
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < numberOfThreads; ++i)
+            threads.emplace_back(worker);
+        worker();
+        for (auto& thread: threads)
+            thread.join();
+    }
+
+    if (layout == Layout::Planar)
+        return output;
+
+    return combineChannels(outputs, layout);
+}
+
+
+/**
+ * \brief Renders one score per channel, see SineWaveSpeech::generateSineWaveSpeech(const SineWaveScore&, std::size_t).
+ *        The channels are rendered on the workerPool() if there is one.
+ *
+ * \param scores     The score of every channel, from analyse()
+ * \param layout     The layout of the returned samples
+ * \param sampleRate The sample rate of the output
+ *
+ * \return Empty if the score of a channel doesn't fit or the channels have different lengths
+ */
+std::vector<float> MultichannelSineWaveSpeech::generateSineWaveSpeech(const std::vector<SineWaveScore>& scores, Layout layout, std::size_t sampleRate)
+{
+    assert(scores.size() == m_channels.size() && "Argument \"scores\" has to contain one score for every channel!");
+
+    std::vector<std::vector<float>> outputs(m_channels.size());
+    forEachChannel([&](std::size_t c) { outputs[c] = m_channels[c]->generateSineWaveSpeech(scores[c], sampleRate); });
+
+    for (const auto& output: outputs)
+    {
+        if (output.size() != outputs[0].size())
+            return std::vector<float>();
+    }
+
+    return combineChannels(outputs, layout);
+}
+
+
+/**
+ * \brief Analyses every channel into its own score, on the workerPool() if there is one.
+ *
+ * \param samples    The samples of all channels in the given layout, normalized in the range [-1, 1]
+ * \param layout     How the channels are arranged in samples
+ * \param sampleRate The sample rate of the samples
+ */
+std::vector<SineWaveScore> MultichannelSineWaveSpeech::analyse(const std::vector<float>& samples, Layout layout, std::size_t sampleRate)
+{
+    assert(samples.size() % m_channels.size() == 0 && "Argument \"samples\" has to contain the same number of samples for every channel!");
+
+    std::vector<SineWaveScore> scores(m_channels.size());
+    forEachChannel([&](std::size_t c) { scores[c] = m_channels[c]->analyse(channelSamples(samples, layout, c), sampleRate); });
+
+    return scores;
+}
+
+
+/**
+ * \brief Sets the sample rate of every channel. Has to be called before processBlock().
+ */
+void MultichannelSineWaveSpeech::sampleRate(std::size_t sampleRate)
+{
+    for (auto& channel: m_channels)
+        channel->sampleRate(sampleRate);
+}
+
+
+/**
+ * \brief Streams a planar block of every channel, see SineWaveSpeech::processBlock().
+ *
+ * \param in  One pointer to n input samples per channel
+ * \param out One pointer to n output samples per channel, may be the same buffers as in
+ * \param n   The number of samples per channel
+ */
+void MultichannelSineWaveSpeech::processBlock(const float* const* in, float* const* out, std::size_t n)
+{
+    for (std::size_t c = 0; c < m_channels.size(); ++c)
+        m_channels[c]->processBlock(in[c], out[c], n);
+}
+
+
+/**
+ * \brief Streams an interleaved block of every channel, see SineWaveSpeech::processBlock().
+ *
+ * \param in  n samples of every channel, interleaved
+ * \param out n samples of every channel, interleaved, may be the same buffer as in
+ * \param n   The number of samples per channel
+ */
+void MultichannelSineWaveSpeech::processInterleaved(const float* in, float* out, std::size_t n)
+{
+    const std::size_t numberOfChannels = m_channels.size();
+
+    for (std::size_t start = 0; start < n; start += interleavedChunkSize)
+    {
+        const std::size_t chunk = std::min(interleavedChunkSize, n - start);
+        const float* chunkIn = in + start * numberOfChannels;
+        float* chunkOut = out + start * numberOfChannels;
+
+        // a channel only reads and writes its own samples, so in and out may be the same
+        for (std::size_t c = 0; c < numberOfChannels; ++c)
+        {
+            for (std::size_t i = 0; i < chunk; ++i)
+                m_channelSamples[i] = chunkIn[i * numberOfChannels + c];
+
+            m_channels[c]->processBlock(m_channelSamples.data(), m_channelSamples.data(), chunk);
+
+            for (std::size_t i = 0; i < chunk; ++i)
+                chunkOut[i * numberOfChannels + c] = m_channelSamples[i];
+        }
+    }
+}
+
+
+/**
+ * \brief Streams an interleaved block of 16 bit samples of every channel, see SineWaveSpeech::processBlock().
+ *        Only after int16Input(true).
+ *
+ * \param in  n samples of every channel, interleaved
+ * \param out n samples of every channel, interleaved
+ * \param n   The number of samples per channel
+ */
+void MultichannelSineWaveSpeech::processInterleaved(const std::int16_t* in, float* out, std::size_t n)
+{
+    const std::size_t numberOfChannels = m_channels.size();
+
+    for (std::size_t start = 0; start < n; start += interleavedChunkSize)
+    {
+        const std::size_t chunk = std::min(interleavedChunkSize, n - start);
+        const std::int16_t* chunkIn = in + start * numberOfChannels;
+        float* chunkOut = out + start * numberOfChannels;
+
+        for (std::size_t c = 0; c < numberOfChannels; ++c)
+        {
+            for (std::size_t i = 0; i < chunk; ++i)
+                m_int16ChannelSamples[i] = chunkIn[i * numberOfChannels + c];
+
+            m_channels[c]->processBlock(m_int16ChannelSamples.data(), m_channelSamples.data(), chunk);
+
+            for (std::size_t i = 0; i < chunk; ++i)
+                chunkOut[i * numberOfChannels + c] = m_channelSamples[i];
+        }
+    }
+}
+
+
+/**
+ * \brief Switches the streaming of every channel between float and 16 bit input, see SineWaveSpeech::int16Input().
+ */
+void MultichannelSineWaveSpeech::int16Input(bool int16Input)
+{
+    for (auto& channel: m_channels)
+        channel->int16Input(int16Input);
+}
+
+
+void MultichannelSineWaveSpeech::reset()
+{
+    for (auto& channel: m_channels)
+        channel->reset();
+}
+
+
+std::size_t MultichannelSineWaveSpeech::latency() const
+{
+    return m_channels[0]->latency();
+}
+
+
+/**
+ * \brief Changes the parameters of every channel, see SineWaveSpeech::parameters().
+ */
+void MultichannelSineWaveSpeech::parameters(const SineWaveSpeech::Parameters& parameters)
+{
+    for (auto& channel: m_channels)
+        channel->parameters(parameters);
+}
+
+
+const SineWaveSpeech::Parameters& MultichannelSineWaveSpeech::parameters() const
+{
+    return m_channels[0]->parameters();
+}
+
+
+void MultichannelSineWaveSpeech::nextToneGenerator()
+{
+    for (auto& channel: m_channels)
+        channel->nextToneGenerator();
+}
+
+
+void MultichannelSineWaveSpeech::synthesis(SineWaveSpeech::Synthesis synthesis)
+{
+    for (auto& channel: m_channels)
+        channel->synthesis(synthesis);
+}
+
+
+void MultichannelSineWaveSpeech::telemetry(Telemetry* telemetry)
+{
+    for (auto& channel: m_channels)
+        channel->telemetry(telemetry);
+}
+
+
+/**
+ * \brief Processes the channels and the shards of their frames on the given pool, nullptr to stop.
+ */
+void MultichannelSineWaveSpeech::workerPool(WorkerPool* workerPool)
+{
+    m_workerPool = workerPool;
+
+    for (auto& channel: m_channels)
+        channel->workerPool(workerPool);
+}
+
+
+void MultichannelSineWaveSpeech::pipelineDepth(std::size_t numberOfFrames)
+{
+    for (auto& channel: m_channels)
+        channel->pipelineDepth(numberOfFrames);
+}
+
+
+std::size_t MultichannelSineWaveSpeech::numberOfChannels() const
+{
+    return m_channels.size();
+}
+
+
+/**
+ * \brief The synthesis of a single channel, e.g. to run it on its own thread.
+ */
+SineWaveSpeech& MultichannelSineWaveSpeech::channel(std::size_t channel)
+{
+    return *m_channels[channel];
+}
+
+
+/**
+ * \brief Calls task(c) for every channel, as tasks of the workerPool() or one after the other without one.
+ */
+void MultichannelSineWaveSpeech::forEachChannel(const std::function<void(std::size_t)>& task)
+{
+    if (m_workerPool)
+    {
+        m_workerPool->run(m_channels.size(), task);
+        return;
+    }
+
+    for (std::size_t c = 0; c < m_channels.size(); ++c)
+        task(c);
+}
+
+
+/**
+ * \brief Copies one channel out of samples.
+ */
+template<typename Sample>
+std::vector<Sample> MultichannelSineWaveSpeech::channelSamples(const std::vector<Sample>& samples, Layout layout, std::size_t channel) const
+{
+    const std::size_t numberOfChannels = m_channels.size();
+    const std::size_t length = samples.size() / numberOfChannels;
+
+    std::vector<Sample> channelSamples(length);
+
+    if (layout == Layout::Interleaved)
+    {
+        for (std::size_t i = 0; i < length; ++i)
+            channelSamples[i] = samples[i * numberOfChannels + channel];
+    }
+    else
+    {
+        std::copy_n(samples.begin() + channel * length, length, channelSamples.begin());
+    }
+
+    return channelSamples;
+}
+
+
+/**
+ * \brief Puts the output of every channel into one buffer with the given layout.
+ */
+std::vector<float> MultichannelSineWaveSpeech::combineChannels(const std::vector<std::vector<float>>& outputs, Layout layout) const
+{
+    const std::size_t numberOfChannels = outputs.size();
+
+    // every channel has the same length, including the zero padding
+    const std::size_t outputLength = outputs[0].size();
+    std::vector<float> output(outputLength * numberOfChannels);
+
+    for (std::size_t c = 0; c < numberOfChannels; ++c)
+    {
+        if (layout == Layout::Interleaved)
+        {
+            for (std::size_t i = 0; i < outputLength; ++i)
+                output[i * numberOfChannels + c] = outputs[c][i];
+        }
+        else
+        {
+            std::copy(outputs[c].begin(), outputs[c].end(), output.begin() + c * outputLength);
+        }
+    }
+
+    return output;
+}
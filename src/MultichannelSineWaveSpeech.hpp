@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef MULTICHANNELSINEWAVESPEECH_HPP
+#define MULTICHANNELSINEWAVESPEECH_HPP
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+#include "SineWaveSpeech.hpp"
+
+/*
+ * \brief Sine wave speech of every channel of a multichannel signal.
+ *        Each channel has its own SineWaveSpeech, so analysis and oscillators never mix
+ *        between channels. Offline the channels run in parallel, live all channels of a
+ *        block are processed in one call.
+ */
+
+class MultichannelSineWaveSpeech
+{
+public:
+
+    // how the channels are arranged in a buffer
+    enum class Layout
+    {
+        Interleaved,    // one sample of every channel after the other, like a WAV file
+        Planar          // all samples of the first channel, then all of the second...
+    };
+
+
+    MultichannelSineWaveSpeech(std::size_t numberOfChannels, std::size_t FFTSize, std::size_t hopSize, std::size_t glideSteps, bool zeroPadAtEnd);
+
+    std::vector<float>         generateSineWaveSpeech(const std::vector<float>& samples, Layout layout, std::size_t sampleRate, std::size_t numberOfThreads = 0);
+    std::vector<float>         generateSineWaveSpeech(const std::vector<std::int16_t>& samples, Layout layout, std::size_t sampleRate, std::size_t numberOfThreads = 0);
+    std::vector<float>         generateSineWaveSpeech(const std::vector<SineWaveScore>& scores, Layout layout, std::size_t sampleRate);
+    std::vector<SineWaveScore> analyse(const std::vector<float>& samples, Layout layout, std::size_t sampleRate);
+
+    void        sampleRate(std::size_t sampleRate);
+    void        processBlock(const float* const* in, float* const* out, std::size_t n);
+    void        processInterleaved(const float* in, float* out, std::size_t n);
+    void        processInterleaved(const std::int16_t* in, float* out, std::size_t n);
+    void        int16Input(bool int16Input);
+    void        reset();
+    std::size_t latency() const;
+
+    void                              parameters(const SineWaveSpeech::Parameters& parameters);
+    const SineWaveSpeech::Parameters& parameters() const;
+
+    void nextToneGenerator();
+    void synthesis(SineWaveSpeech::Synthesis synthesis);
+    void telemetry(Telemetry* telemetry);
+    void workerPool(WorkerPool* workerPool);
+    void pipelineDepth(std::size_t numberOfFrames);
+
+    std::size_t     numberOfChannels() const;
+    SineWaveSpeech& channel(std::size_t channel);
+
+private:
+    template<typename Sample>
+    std::vector<float> generate(const std::vector<Sample>& samples, Layout layout, std::size_t sampleRate, std::size_t numberOfThreads);
+    void               forEachChannel(const std::function<void(std::size_t)>& task);
+    template<typename Sample>
+    std::vector<Sample> channelSamples(const std::vector<Sample>& samples, Layout layout, std::size_t channel) const;
+    std::vector<float> combineChannels(const std::vector<std::vector<float>>& outputs, Layout layout) const;
+
+    std::vector<std::unique_ptr<SineWaveSpeech>> m_channels;
+    WorkerPool*                                  m_workerPool;
+
+    // one channel of an interleaved block
+    std::vector<float>                           m_channelSamples;
+    std::vector<std::int16_t>                    m_int16ChannelSamples;
+};
+
+
+#endif // MULTICHANNELSINEWAVESPEECH_HPP
@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "NullAudioHost.hpp"
+
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cassert>
+
+
+/**
+ * \param input         The file to play, has to outlive the host
+ * \param periodSizes   The sizes of the periods in samples, repeated in this order
+ * \param deadlineScale The deadline of a callback as a fraction of its period,
+ *                      e.g. 0.5 simulates a machine that is half as fast
+ * \param realTime      Whether to wait for the simulated sound card between periods, which
+ *                      gives worker threads the same time they would have with real hardware
+ */
+NullAudioHost::NullAudioHost(const WavFile& input, std::vector<std::size_t> periodSizes, double deadlineScale, bool realTime) :
+    m_input(input),
+    m_periodSizes(std::move(periodSizes)),
+    m_deadlineScale(deadlineScale),
+    m_realTime(realTime),
+    m_running(false),
+    m_xruns(0),
+    m_report{ {}, 0, 0.0, 0.0, 0.0 }
+{
+    assert(!m_periodSizes.empty() && "Argument \"periodSizes\" needs at least one period size!");
+    assert(std::find(m_periodSizes.begin(), m_periodSizes.end(), 0) == m_periodSizes.end() && "Argument \"periodSizes\" can't contain 0!");
+}
+
+
+std::size_t NullAudioHost::sampleRate()
+{
+    return m_input.sampleRate();
+}
+
+
+std::size_t NullAudioHost::numberOfChannels()
+{
+    return m_input.numberOfChannels();
+}
+
+
+std::size_t NullAudioHost::maxPeriodSize()
+{
+    return *std::max_element(m_periodSizes.begin(), m_periodSizes.end());
+}
+
+
+/**
+ * \brief A real sound card would have run out of samples for every missed deadline.
+ */
+std::size_t NullAudioHost::xruns()
+{
+    return m_xruns;
+}
+
+
+void NullAudioHost::start(Callback callback)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const std::size_t numberOfChannels = m_input.numberOfChannels();
+    const std::size_t numberOfFrames = m_input.numberOfFrames();
+    const std::vector<float>& input = m_input.samples();
+
+    // planar period buffers like a sound card driver would hand out
+    const std::size_t maxPeriod = maxPeriodSize();
+    std::vector<float> inputBuffer(numberOfChannels * maxPeriod);
+    std::vector<float> outputBuffer(numberOfChannels * maxPeriod);
+    std::vector<const float*> inputPointers(numberOfChannels);
+    std::vector<float*> outputPointers(numberOfChannels);
+    for (std::size_t c = 0; c < numberOfChannels; ++c)
+    {
+        inputPointers[c] = &inputBuffer[c * maxPeriod];
+        outputPointers[c] = &outputBuffer[c * maxPeriod];
+    }
+
+    m_report = Report{ {}, 0, 0.0, 0.0, 0.0 };
+    m_report.periods.reserve(numberOfFrames / *std::min_element(m_periodSizes.begin(), m_periodSizes.end()) + 1);
+    m_output.assign(input.size(), 0.f);
+    m_xruns = 0;
+    m_running = true;
+
+    const auto startTime = Clock::now();
+    std::size_t position = 0;
+    double computeTime = 0.0;
+
+    for (std::size_t period = 0; position < numberOfFrames && m_running; ++period)
+    {
+        const std::size_t n = m_periodSizes[period % m_periodSizes.size()];
+        const std::size_t frames = std::min(n, numberOfFrames - position);
+
+        // the last period is padded with silence, a sound card always delivers whole periods
+        for (std::size_t c = 0; c < numberOfChannels; ++c)
+        {
+            float* channel = &inputBuffer[c * maxPeriod];
+            for (std::size_t i = 0; i < frames; ++i)
+                channel[i] = input[(position + i) * numberOfChannels + c];
+            std::fill(channel + frames, channel + n, 0.f);
+        }
+
+        if (m_realTime)
+            std::this_thread::sleep_until(startTime + std::chrono::duration<double>(static_cast<double>(position) / sampleRate()));
+
+        const auto callbackStart = Clock::now();
+        callback(inputPointers.data(), outputPointers.data(), n);
+        const double duration = std::chrono::duration<double>(Clock::now() - callbackStart).count();
+
+        const double deadline = m_deadlineScale * n / sampleRate();
+        m_report.periods.push_back( Period{ n, duration, deadline } );
+        if (duration > deadline)
+        {
+            ++m_report.deadlineMisses;
+            ++m_xruns;
+        }
+        m_report.maxComputeTime = std::max(m_report.maxComputeTime, duration);
+        m_report.maxLoad = std::max(m_report.maxLoad, duration / deadline);
+        computeTime += duration;
+
+        for (std::size_t c = 0; c < numberOfChannels; ++c)
+        {
+            const float* channel = &outputBuffer[c * maxPeriod];
+            for (std::size_t i = 0; i < frames; ++i)
+                m_output[(position + i) * numberOfChannels + c] = channel[i];
+        }
+
+        position += frames;
+    }
+
+    if (!m_report.periods.empty())
+        m_report.meanComputeTime = computeTime / m_report.periods.size();
+
+    m_running = false;
+}
+
+
+/**
+ * \brief Ends start() after the current period, can be called from the callback or another thread.
+ */
+void NullAudioHost::stop()
+{
+    m_running = false;
+}
+
+
+/**
+ * \brief The timing of every period of the last start().
+ */
+const NullAudioHost::Report& NullAudioHost::report() const
+{
+    return m_report;
+}
+
+
+/**
+ * \brief Everything the callback played, interleaved like the input file.
+ */
+const std::vector<float>& NullAudioHost::output() const
+{
+    return m_output;
+}
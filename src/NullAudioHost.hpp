@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef NULLAUDIOHOST_HPP
+#define NULLAUDIOHOST_HPP
+
+#include <vector>
+#include <atomic>
+
+#include "AudioHost.hpp"
+#include "WavFile.hpp"
+
+/*
+ * \brief A sound card simulated from a WAV file, to run the live path without an audio server.
+ *        The file is played in periods, the period sizes repeat in the given order, so irregular
+ *        periods can be reproduced. Every callback is timed against its deadline, the duration
+ *        of its period. The clock is simulated, so by default the periods follow each other as
+ *        fast as possible; in real-time mode each period waits until it would arrive from a sound card.
+ */
+
+class NullAudioHost: public AudioHost
+{
+public:
+
+    // the compute time of the callback of one period
+    struct Period
+    {
+        std::size_t size;
+        double      computeTime;    // seconds
+        double      deadline;       // seconds
+    };
+
+    struct Report
+    {
+        std::vector<Period>   periods;
+        std::size_t           deadlineMisses;
+        double                maxComputeTime;   // seconds
+        double                meanComputeTime;  // seconds
+        double                maxLoad;          // compute time / deadline of the worst callback
+    };
+
+
+    NullAudioHost(const WavFile& input, std::vector<std::size_t> periodSizes, double deadlineScale = 1.0, bool realTime = false);
+
+    std::size_t sampleRate() override;
+    std::size_t numberOfChannels() override;
+    std::size_t maxPeriodSize() override;
+    std::size_t xruns() override;
+
+    // plays the whole file on the calling thread, returns when it's done or stop() was called
+    void start(Callback callback) override;
+    void stop() override;
+
+    const Report&             report() const;
+    const std::vector<float>& output() const;
+
+
+private:
+    const WavFile&             m_input;
+    std::vector<std::size_t>   m_periodSizes;
+    double                     m_deadlineScale;
+    bool                       m_realTime;
+    std::atomic<bool>          m_running;
+    std::atomic<std::size_t>   m_xruns;
+    Report                     m_report;
+    std::vector<float>         m_output;
+};
+
+
+#endif // NULLAUDIOHOST_HPP
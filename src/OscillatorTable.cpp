@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "OscillatorTable.hpp"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+
+namespace
+{
+    const double twoPI = 8.0 * std::atan(1.0);
+
+    using TableKey = std::tuple<std::size_t, std::size_t, std::size_t>;
+
+    std::mutex                                                s_tableMutex;
+    std::map<TableKey, std::weak_ptr<const OscillatorTable>>  s_tables;
+}
+
+
+/**
+ * \param sampleRate         The sample rate the oscillators run at
+ * \param numberOfBins       The number of bins of the magnitude spectrum (FFTSize / 2)
+ * \param analysisSampleRate The sample rate of the analysed signal, the bins are centered on its frequencies.
+ *                           0 is the same as sampleRate.
+ */
+OscillatorTable::OscillatorTable(std::size_t sampleRate, std::size_t numberOfBins, std::size_t analysisSampleRate) :
+    m_sampleRate(sampleRate),
+    m_numberOfBins(numberOfBins),
+    m_analysisSampleRate(analysisSampleRate ? analysisSampleRate : sampleRate),
+    m_bandwidth(m_analysisSampleRate / 2.0 / numberOfBins),
+    m_middleFrequency(m_bandwidth / 2.0),
+    m_coefficients(numberOfBins)
+{
+    for (std::size_t i = 0; i < m_coefficients.size(); i++)
+    {
+        const double frequency = m_middleFrequency + m_bandwidth * i;
+        const double step = twoPI * frequency / m_sampleRate;
+
+        m_coefficients[i] = { frequency, step, std::sin(step), std::cos(step) };
+    }
+}
+
+
+/**
+ * \brief Returns the shared table for the given parameters, creating it if no one holds it yet.
+ *        The parameters are the same as for the constructor.
+ */
+std::shared_ptr<const OscillatorTable> OscillatorTable::get(std::size_t sampleRate, std::size_t numberOfBins, std::size_t analysisSampleRate)
+{
+    if (analysisSampleRate == 0)
+        analysisSampleRate = sampleRate;
+
+    std::lock_guard<std::mutex> lock(s_tableMutex);
+
+    auto& cached = s_tables[TableKey(sampleRate, numberOfBins, analysisSampleRate)];
+    auto table = cached.lock();
+    if (!table)
+    {
+        table = std::make_shared<const OscillatorTable>(sampleRate, numberOfBins, analysisSampleRate);
+        cached = table;
+    }
+
+    return table;
+}
+
+
+const OscillatorCoefficients& OscillatorTable::bin(std::size_t bin) const
+{
+    return m_coefficients[bin];
+}
+
+
+std::size_t OscillatorTable::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+
+std::size_t OscillatorTable::numberOfBins() const
+{
+    return m_numberOfBins;
+}
+
+
+std::size_t OscillatorTable::analysisSampleRate() const
+{
+    return m_analysisSampleRate;
+}
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef OSCILLATORTABLE_HPP
+#define OSCILLATORTABLE_HPP
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+/*
+ * \brief The rotation coefficients of a sinusoid at one frequency.
+ *        step is the phase increment per sample, sinus and cosinus are sin() and cos() of it.
+ */
+
+struct OscillatorCoefficients
+{
+    double frequency;
+    double step;
+    double sinus;
+    double cosinus;
+};
+
+/*
+ * \brief Precomputed oscillator coefficients for every frequency the synthesis can produce.
+ *        The synthesized frequencies are always the center of an FFT bin, everything in between
+ *        is part of a glide that the generators render from the coefficients at both ends.
+ *        Tables are immutable and shared, use get() to obtain one.
+ */
+
+class OscillatorTable
+{
+public:
+
+    OscillatorTable(std::size_t sampleRate, std::size_t numberOfBins, std::size_t analysisSampleRate = 0);
+
+    static std::shared_ptr<const OscillatorTable> get(std::size_t sampleRate, std::size_t numberOfBins, std::size_t analysisSampleRate = 0);
+
+    const OscillatorCoefficients& bin(std::size_t bin) const;
+
+    std::size_t sampleRate()         const;
+    std::size_t numberOfBins()       const;
+    std::size_t analysisSampleRate() const;
+
+private:
+    std::size_t                         m_sampleRate;
+    std::size_t                         m_numberOfBins;
+    std::size_t                         m_analysisSampleRate;
+    double                              m_bandwidth;
+    double                              m_middleFrequency;
+    std::vector<OscillatorCoefficients> m_coefficients;
+};
+
+#endif // OSCILLATORTABLE_HPP
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "PCM.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+    // rounds half away from zero and saturates, samples outside of [-1, 1] become +-32767.
+    // Rounding before clamping keeps the loops free of branches, so they vectorize
+    inline std::int16_t toInt16(float sample)
+    {
+        const float scaled = sample * 32767.f + std::copysign(0.5f, sample);
+        return static_cast<std::int16_t>(std::max(-32767.f, std::min(32767.f, scaled)));
+    }
+}
+
+
+namespace PCM
+{
+    /**
+     * \brief Decodes little endian 16, 24 or 32 bit integer or 32 bit float samples.
+     *
+     * \param format         formatInteger or formatFloat
+     * \param bytesPerSample 2, 3 or 4 for integers, 4 for floats
+     */
+    void decode(const unsigned char* bytes, std::uint16_t format, std::size_t bytesPerSample, float* samples, std::size_t numberOfSamples)
+    {
+        if (format == formatFloat)
+        {
+            for (std::size_t i = 0; i < numberOfSamples; ++i)
+            {
+                const std::uint32_t bits = bytes[4 * i] | bytes[4 * i + 1] << 8 | bytes[4 * i + 2] << 16 | static_cast<std::uint32_t>(bytes[4 * i + 3]) << 24;
+                std::memcpy(samples + i, &bits, sizeof(float));
+            }
+        }
+        else if (bytesPerSample == 2)
+        {
+            for (std::size_t i = 0; i < numberOfSamples; ++i)
+                samples[i] = static_cast<std::int16_t>(bytes[2 * i] | bytes[2 * i + 1] << 8) * int16Scale;
+        }
+        else if (bytesPerSample == 3)
+        {
+            // the sample goes into the upper bytes of an int32, so the sign is right
+            for (std::size_t i = 0; i < numberOfSamples; ++i)
+                samples[i] = static_cast<std::int32_t>(static_cast<std::uint32_t>(bytes[3 * i] << 8 | bytes[3 * i + 1] << 16 | bytes[3 * i + 2] << 24)) * (1.f / 2147483648.f);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < numberOfSamples; ++i)
+                samples[i] = static_cast<std::int32_t>(bytes[4 * i] | bytes[4 * i + 1] << 8 | bytes[4 * i + 2] << 16 | static_cast<std::uint32_t>(bytes[4 * i + 3]) << 24) * (1.f / 2147483648.f);
+        }
+    }
+
+
+    /**
+     * \brief Encodes samples as little endian 16 bit integers, see floatToInt16().
+     */
+    void encodeInt16(const float* samples, unsigned char* bytes, std::size_t numberOfSamples)
+    {
+        for (std::size_t i = 0; i < numberOfSamples; ++i)
+        {
+            const std::uint16_t bits = static_cast<std::uint16_t>(toInt16(samples[i]));
+            bytes[2 * i] = static_cast<unsigned char>(bits);
+            bytes[2 * i + 1] = static_cast<unsigned char>(bits >> 8);
+        }
+    }
+
+
+    /**
+     * \brief Encodes samples as little endian 32 bit floats, without clipping.
+     */
+    void encodeFloat(const float* samples, unsigned char* bytes, std::size_t numberOfSamples)
+    {
+        for (std::size_t i = 0; i < numberOfSamples; ++i)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, samples + i, sizeof(bits));
+            bytes[4 * i] = static_cast<unsigned char>(bits);
+            bytes[4 * i + 1] = static_cast<unsigned char>(bits >> 8);
+            bytes[4 * i + 2] = static_cast<unsigned char>(bits >> 16);
+            bytes[4 * i + 3] = static_cast<unsigned char>(bits >> 24);
+        }
+    }
+
+
+    void int16ToFloat(const std::int16_t* in, float* out, std::size_t numberOfSamples)
+    {
+        for (std::size_t i = 0; i < numberOfSamples; ++i)
+            out[i] = in[i] * int16Scale;
+    }
+
+
+    /**
+     * \brief Converts samples to 16 bit, scaled by 32767 and saturated, so a sample outside
+     *        of [-1, 1] can't wrap around.
+     */
+    void floatToInt16(const float* in, std::int16_t* out, std::size_t numberOfSamples)
+    {
+        for (std::size_t i = 0; i < numberOfSamples; ++i)
+            out[i] = toInt16(in[i]);
+    }
+}
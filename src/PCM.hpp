@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef PCM_HPP
+#define PCM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * \brief Conversions between PCM samples and normalized floats.
+ *        Every conversion is a plain loop over the samples without branches on the format
+ *        inside, so the compiler can turn them into SIMD code. Integers are read as n / 2^(bits - 1),
+ *        floats are written as 16 bit integers with rounding and saturation at [-1, 1].
+ *        The byte versions read and write little endian, like WAV files, on any machine.
+ */
+
+namespace PCM
+{
+    // the format codes of WAV files
+    const std::uint16_t formatInteger = 1;
+    const std::uint16_t formatFloat = 3;
+
+    const float int16Scale = 1.f / 32768.f;
+
+    void decode(const unsigned char* bytes, std::uint16_t format, std::size_t bytesPerSample, float* samples, std::size_t numberOfSamples);
+    void encodeInt16(const float* samples, unsigned char* bytes, std::size_t numberOfSamples);
+    void encodeFloat(const float* samples, unsigned char* bytes, std::size_t numberOfSamples);
+
+    void int16ToFloat(const std::int16_t* in, float* out, std::size_t numberOfSamples);
+    void floatToInt16(const float* in, std::int16_t* out, std::size_t numberOfSamples);
+}
+
+
+#endif // PCM_HPP
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef SPSCRING_INCLUDE
+#define SPSCRING_INCLUDE
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+/*
+ * \brief A wait-free single producer single consumer ring buffer.
+ *        One thread may write() while another thread read()s, neither blocks or allocates.
+ *        The capacity is rounded up to a power of 2.
+ */
+
+template <typename T>
+class SPSCRing
+{
+public:
+    SPSCRing(std::size_t capacity) :
+        m_buffer(roundUpToPowerOf2(capacity)),
+        m_mask(m_buffer.size() - 1),
+        m_writePosition(0),
+        m_readPosition(0)
+    {
+
+    }
+
+    // writes up to n elements, returns how many fit. Only call from the producer thread
+    std::size_t write(const T* data, std::size_t n)
+    {
+        const std::size_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+        const std::size_t readPosition = m_readPosition.load(std::memory_order_acquire);
+
+        n = std::min(n, m_buffer.size() - (writePosition - readPosition));
+
+        const std::size_t start = writePosition & m_mask;
+        const std::size_t firstPart = std::min(n, m_buffer.size() - start);
+        std::copy_n(data, firstPart, m_buffer.begin() + start);
+        std::copy_n(data + firstPart, n - firstPart, m_buffer.begin());
+
+        m_writePosition.store(writePosition + n, std::memory_order_release);
+        return n;
+    }
+
+    // reads up to n elements, returns how many were available. Only call from the consumer thread
+    std::size_t read(T* data, std::size_t n)
+    {
+        const std::size_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+        const std::size_t writePosition = m_writePosition.load(std::memory_order_acquire);
+
+        n = std::min(n, writePosition - readPosition);
+
+        const std::size_t start = readPosition & m_mask;
+        const std::size_t firstPart = std::min(n, m_buffer.size() - start);
+        std::copy_n(m_buffer.begin() + start, firstPart, data);
+        std::copy_n(m_buffer.begin(), n - firstPart, data + firstPart);
+
+        m_readPosition.store(readPosition + n, std::memory_order_release);
+        return n;
+    }
+
+    // drops up to n elements, returns how many were dropped. Only call from the consumer thread
+    std::size_t skip(std::size_t n)
+    {
+        const std::size_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+        const std::size_t writePosition = m_writePosition.load(std::memory_order_acquire);
+
+        n = std::min(n, writePosition - readPosition);
+
+        m_readPosition.store(readPosition + n, std::memory_order_release);
+        return n;
+    }
+
+    std::size_t readAvailable() const
+    {
+        return m_writePosition.load(std::memory_order_acquire) - m_readPosition.load(std::memory_order_acquire);
+    }
+
+    std::size_t writeAvailable() const
+    {
+        return m_buffer.size() - readAvailable();
+    }
+
+    std::size_t capacity() const
+    {
+        return m_buffer.size();
+    }
+
+
+private:
+    static std::size_t roundUpToPowerOf2(std::size_t n)
+    {
+        std::size_t powerOf2 = 1;
+        while (powerOf2 < n)
+            powerOf2 <<= 1;
+        return powerOf2;
+    }
+
+    std::vector<T>            m_buffer;
+    const std::size_t         m_mask;
+
+    // the positions only ever grow, the difference is the fill level.
+    // Separate cache lines, so producer and consumer don't invalidate each other
+    alignas(64) std::atomic<std::size_t>  m_writePosition;
+    alignas(64) std::atomic<std::size_t>  m_readPosition;
+};
+
+#endif // SPSCRING_INCLUDE
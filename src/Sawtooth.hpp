@@ -52,17 +52,58 @@ public:
         return m_amplitude * sample;
     }
 
+    std::unique_ptr<ToneGenerator> clone() const override
+    {
+        return std::make_unique<Sawtooth>(*this);
+    }
+
+    void reset(double frequency, double amplitude) override
+    {
+        m_nextSample = -1.0;
+
+        ToneGenerator::reset(frequency, amplitude);
+    }
+
     void frequency(double frequency) override
     {
         m_frequency = frequency;
         m_step = 2.0 * m_frequency / sampleRate;
     }
+
+    // renders sample by sample, but ends in the state of advance(), so a shard that advanced over
+    // the frames before it continues exactly where rendering all of them would
+    void render(float* output, std::size_t count, const OscillatorCoefficients& target, double targetAmplitude, std::size_t glideSteps) override
+    {
+        const double nextSample = advancedSample(count, target, glideSteps);
+        ToneGenerator::render(output, count, target, targetAmplitude, glideSteps);
+        endFrame(nextSample, target, targetAmplitude);
+    }
+
+    // the ramp is linear in the phase, so its end is known without rendering it
+    void advance(std::size_t count, const OscillatorCoefficients& target, double targetAmplitude, std::size_t glideSteps) override
+    {
+        endFrame(advancedSample(count, target, glideSteps), target, targetAmplitude);
+    }
     
     using ToneGenerator::frequency;
     using ToneGenerator::amplitude;
 
 
 private:
+    // the next sample after count samples of render(), wrapped into (-1, 1] like getNextSample() does
+    double advancedSample(std::size_t count, const OscillatorCoefficients& target, std::size_t glideSteps) const
+    {
+        const double sample = m_nextSample + 2.0 * frequencySum(count, target.frequency, glideSteps) / sampleRate;
+        return sample > 1.0 ? sample - 2.0 * std::ceil((sample - 1.0) / 2.0) : sample;
+    }
+
+    void endFrame(double nextSample, const OscillatorCoefficients& target, double targetAmplitude)
+    {
+        m_nextSample = nextSample;
+        frequency(target);
+        m_amplitude = targetAmplitude;
+    }
+
     double m_nextSample;
     double m_step;
 };
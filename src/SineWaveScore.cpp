@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "SineWaveScore.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+
+namespace
+{
+    const char        magic[4] = { 'S', 'W', 'S', 'C' };
+    const std::size_t headerSize = 36;
+    const std::size_t trackSize = 6;
+
+    std::uint64_t readLittleEndian(const unsigned char* bytes, std::size_t numberOfBytes)
+    {
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < numberOfBytes; ++i)
+            value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+        return value;
+    }
+
+    void writeLittleEndian(unsigned char* bytes, std::uint64_t value, std::size_t numberOfBytes)
+    {
+        for (std::size_t i = 0; i < numberOfBytes; ++i)
+            bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+
+const std::uint16_t SineWaveScore::version;
+const std::size_t   SineWaveScore::maximumFFTSize;
+
+
+SineWaveScore::SineWaveScore() :
+    SineWaveScore(0, 0, 0, 0, 1)
+{
+
+}
+
+
+/**
+ * \param sampleRate      The sample rate of the analysed signal
+ * \param FFTSize         The analysis window, the bins are relative to it
+ * \param hopSize         The distance between two frames in samples
+ * \param numberOfSamples The length of the analysed signal including the zero padding
+ * \param tracksPerFrame  How many tracks every frame has
+ */
+SineWaveScore::SineWaveScore(std::size_t sampleRate, std::size_t FFTSize, std::size_t hopSize, std::size_t numberOfSamples, std::size_t tracksPerFrame) :
+    m_sampleRate(sampleRate),
+    m_FFTSize(FFTSize),
+    m_hopSize(hopSize),
+    m_numberOfSamples(numberOfSamples),
+    m_tracksPerFrame(tracksPerFrame)
+{
+
+}
+
+
+/**
+ * \brief Loads a score, the whole file is checked before anything is changed.
+ *
+ * \return Whether the file could be read, the reason is printed if not
+ */
+bool SineWaveScore::loadFromFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Could not open \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    unsigned char header[headerSize];
+    if (!file.read(reinterpret_cast<char*>(header), headerSize) || std::memcmp(header, magic, 4) != 0)
+    {
+        std::cerr << "\"" << path << "\" is not a sine wave score." << std::endl;
+        return false;
+    }
+
+    const std::size_t fileVersion = readLittleEndian(header + 4, 2);
+    if (fileVersion == 0 || fileVersion > version)
+    {
+        std::cerr << "\"" << path << "\" has version " << fileVersion << ", only versions up to " << version << " are supported." << std::endl;
+        return false;
+    }
+
+    const std::size_t tracksPerFrame = readLittleEndian(header + 6, 2);
+    const std::size_t sampleRate = readLittleEndian(header + 8, 4);
+    const std::size_t FFTSize = readLittleEndian(header + 12, 4);
+    const std::size_t hopSize = readLittleEndian(header + 16, 4);
+    const std::size_t numberOfSamples = readLittleEndian(header + 20, 8);
+    const std::uint64_t numberOfFrames = readLittleEndian(header + 28, 8);
+
+    // the FFT size has to be a power of 2 and the frames have to fit into the analysed signal
+    const bool valid = tracksPerFrame > 0 && sampleRate > 0 && FFTSize >= 2 && FFTSize <= maximumFFTSize
+                    && (FFTSize & (FFTSize - 1)) == 0 && hopSize > 0 && numberOfFrames <= numberOfSamples / hopSize + 1;
+    if (!valid)
+    {
+        std::cerr << "\"" << path << "\" has an invalid header." << std::endl;
+        return false;
+    }
+
+    // the header is not trusted with the size of the allocation, the tracks have to be in the file.
+    // tracksPerFrame has 16 bits, so the frame size cannot overflow and the division bounds the product.
+    const std::streamoff dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::uint64_t bytesLeft = static_cast<std::uint64_t>(file.tellg() - dataStart);
+    file.seekg(dataStart);
+
+    const std::uint64_t frameSize = tracksPerFrame * trackSize;
+    if (!file || numberOfFrames > bytesLeft / frameSize)
+    {
+        std::cerr << "\"" << path << "\" is truncated." << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> data(numberOfFrames * frameSize);
+    if (!file.read(reinterpret_cast<char*>(data.data()), data.size()))
+    {
+        std::cerr << "\"" << path << "\" is truncated." << std::endl;
+        return false;
+    }
+
+    std::vector<Track> tracks(numberOfFrames * tracksPerFrame);
+    for (std::size_t i = 0; i < tracks.size(); ++i)
+    {
+        const unsigned char* bytes = data.data() + i * trackSize;
+        const std::uint32_t rms = static_cast<std::uint32_t>(readLittleEndian(bytes + 2, 4));
+
+        tracks[i].bin = static_cast<std::uint16_t>(readLittleEndian(bytes, 2));
+        std::memcpy(&tracks[i].rms, &rms, sizeof(float));
+
+        if (tracks[i].bin >= FFTSize / 2)
+        {
+            std::cerr << "\"" << path << "\" has a bin outside of the spectrum." << std::endl;
+            return false;
+        }
+    }
+
+    m_sampleRate = sampleRate;
+    m_FFTSize = FFTSize;
+    m_hopSize = hopSize;
+    m_numberOfSamples = numberOfSamples;
+    m_tracksPerFrame = tracksPerFrame;
+    m_tracks = std::move(tracks);
+
+    return true;
+}
+
+
+/**
+ * \brief Saves the score in the current version of the format.
+ *
+ * \return Whether the file could be written
+ */
+bool SineWaveScore::saveToFile(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Could not create \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> data(headerSize + m_tracks.size() * trackSize);
+
+    std::memcpy(data.data(), magic, 4);
+    writeLittleEndian(data.data() + 4, version, 2);
+    writeLittleEndian(data.data() + 6, m_tracksPerFrame, 2);
+    writeLittleEndian(data.data() + 8, m_sampleRate, 4);
+    writeLittleEndian(data.data() + 12, m_FFTSize, 4);
+    writeLittleEndian(data.data() + 16, m_hopSize, 4);
+    writeLittleEndian(data.data() + 20, m_numberOfSamples, 8);
+    writeLittleEndian(data.data() + 28, numberOfFrames(), 8);
+
+    for (std::size_t i = 0; i < m_tracks.size(); ++i)
+    {
+        unsigned char* bytes = data.data() + headerSize + i * trackSize;
+        std::uint32_t rms;
+        std::memcpy(&rms, &m_tracks[i].rms, sizeof(rms));
+
+        writeLittleEndian(bytes, m_tracks[i].bin, 2);
+        writeLittleEndian(bytes + 2, rms, 4);
+    }
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    return static_cast<bool>(file);
+}
+
+
+/**
+ * \brief Appends a frame.
+ *
+ * \param tracks tracksPerFrame() tracks
+ */
+void SineWaveScore::addFrame(const Track* tracks)
+{
+    m_tracks.insert(m_tracks.end(), tracks, tracks + m_tracksPerFrame);
+}
+
+
+/**
+ * \brief The tracksPerFrame() tracks of a frame.
+ */
+const SineWaveScore::Track* SineWaveScore::frame(std::size_t index) const
+{
+    return m_tracks.data() + index * m_tracksPerFrame;
+}
+
+
+std::size_t SineWaveScore::numberOfFrames() const
+{
+    return m_tracks.size() / m_tracksPerFrame;
+}
+
+
+std::size_t SineWaveScore::tracksPerFrame() const
+{
+    return m_tracksPerFrame;
+}
+
+
+std::size_t SineWaveScore::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+
+std::size_t SineWaveScore::FFTSize() const
+{
+    return m_FFTSize;
+}
+
+
+std::size_t SineWaveScore::hopSize() const
+{
+    return m_hopSize;
+}
+
+
+std::size_t SineWaveScore::numberOfSamples() const
+{
+    return m_numberOfSamples;
+}
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef SINEWAVESCORE_HPP
+#define SINEWAVESCORE_HPP
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * \brief The analysis of a signal, everything the synthesis needs to render it again.
+ *        Every frame holds the tracks found in it, a track is the bin of a spectral peak and
+ *        the RMS of the frame. Resynthesizing a score skips every FFT, so it can
+ *        be rendered with other generators, glides or at another sample rate for almost nothing.
+ *
+ * The file format, all numbers little endian:
+ *   "SWSC", uint16 version, uint16 tracks per frame, uint32 sample rate, uint32 FFT size,
+ *   uint32 hop size, uint64 number of analysed samples, uint64 number of frames,
+ *   then for every frame and track: uint16 bin, float32 RMS
+ * That is 6 bytes per frame and track instead of hopSize samples of audio.
+ */
+
+class SineWaveScore
+{
+public:
+    static const std::uint16_t version = 1;
+    static const std::size_t   maximumFFTSize = 131072;    // the bins below FFTSize / 2 have to fit into 16 bits
+
+    struct Track
+    {
+        std::uint16_t bin;
+        float         rms;
+    };
+
+
+    SineWaveScore();
+    SineWaveScore(std::size_t sampleRate, std::size_t FFTSize, std::size_t hopSize, std::size_t numberOfSamples, std::size_t tracksPerFrame = 1);
+
+    bool loadFromFile(const std::string& path);
+    bool saveToFile(const std::string& path) const;
+
+    void         addFrame(const Track* tracks);
+    const Track* frame(std::size_t index) const;
+
+    std::size_t numberOfFrames() const;
+    std::size_t tracksPerFrame() const;
+    std::size_t sampleRate() const;
+    std::size_t FFTSize() const;
+    std::size_t hopSize() const;
+    std::size_t numberOfSamples() const;
+
+
+private:
+    std::size_t         m_sampleRate;
+    std::size_t         m_FFTSize;
+    std::size_t         m_hopSize;
+    std::size_t         m_numberOfSamples;
+    std::size_t         m_tracksPerFrame;
+    std::vector<Track>  m_tracks;           // frame after frame
+};
+
+
+#endif // SINEWAVESCORE_HPP
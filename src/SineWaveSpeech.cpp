@@ -24,22 +24,93 @@
 #include <iomanip>
 #include <numeric>
 #include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <thread>
 
 #include "SineWaveSpeech.hpp"
 #include "Sinusoid.hpp"
 #include "Triangle.hpp"
 #include "Sawtooth.hpp"
+#include "Telemetry.hpp"
+#include "WorkerPool.hpp"
+#include "BoundedQueue.hpp"
+#include "PCM.hpp"
+
+
+namespace
+{
+    // with a worker pool, a signal is split into shards of at least this many frames,
+    // and into a few per thread so the threads that finish early can steal the rest
+    const std::size_t minimumShardFrames = 64;
+    const std::size_t shardsPerThread = 4;
+    
+    // the silent tone every generator starts with and returns to on reset()
+    const double initialFrequency = 440.0;
+
+    // copies a ring into frame, the oldest sample is at the write position
+    template<typename Sample>
+    void unwrapRing(const std::vector<Sample>& ring, std::size_t position, std::vector<Sample>& frame)
+    {
+        std::copy(ring.begin() + position, ring.end(), frame.begin());
+        std::copy(ring.begin(), ring.begin() + position, frame.end() - position);
+    }
+}
+
+
+/**
+ * \param FFTSize The length of the analysis window, has to be a power of 2
+ */
+SineWaveSpeech::Workspace::Workspace(std::size_t FFTSize) :
+    magnitudeSpectrum(FFTSize, MagnitudeSpectrum::Range::ExcludeDC_IncludeNyquist),
+    frameSamples(FFTSize),
+    int16FrameSamples(FFTSize),
+    spectrum(FFTSize)
+{
+}
+
 
 SineWaveSpeech::SineWaveSpeech(std::size_t FFTSize, bool zeroPadAtEnd) :
+    SineWaveSpeech(FFTSize, FFTSize / 2, 50, zeroPadAtEnd)
+{
+}
+
+
+/**
+ * \param FFTSize      The length of the analysis window, has to be a power of 2
+ * \param hopSize      The distance between two frames in samples, from FFTSize / 8 (87.5% overlap)
+ *                     to FFTSize (no overlap). Every frame synthesizes hopSize samples.
+ * \param glideSteps   The number of samples the frequency and amplitude glide at the start of a frame,
+ *                     limited to hopSize
+ * \param zeroPadAtEnd Whether to pad the input with zeros so the last frame is complete
+ * \param ownWorkspace Whether to allocate a Workspace for processBlock(). Without, every block has to
+ *                     bring one, which keeps many streams small that are processed by a few threads.
+ */
+SineWaveSpeech::SineWaveSpeech(std::size_t FFTSize, std::size_t hopSize, std::size_t glideSteps, bool zeroPadAtEnd, bool ownWorkspace) :
     m_FFTSize(FFTSize),
-    m_magnitudeSpectrum(FFTSize, MagnitudeSpectrum::Range::ExcludeDC_IncludeNyquist),
+    m_hopSize(hopSize),
     m_sampleRate(0),
-    m_currentToneGenerator(0),
-    m_zeroPadAtEnd(zeroPadAtEnd)
+    m_analysisSampleRate(0),
+    m_zeroPadAtEnd(zeroPadAtEnd),
+    m_spectralSynthesizer(FFTSize, std::min(hopSize, FFTSize / 2)),
+    m_partials(1),
+    m_workerPool(nullptr),
+    m_pipelineDepth(0),
+    m_workspace(ownWorkspace ? std::make_unique<Workspace>(FFTSize) : nullptr),
+    m_controlParameters{ 3000.f, std::sqrt(2.f), std::max<std::size_t>(1, std::min(glideSteps, hopSize)), 0, Synthesis::ToneGenerator },
+    m_parameterChannel(m_controlParameters),
+    m_parameters(m_controlParameters),
+    m_inputRing(FFTSize),
+    m_synthesisBuffer(FFTSize),
+    m_telemetry(nullptr)
 {
-    m_toneGenertors.push_back( std::make_unique<Sinusoid>(440, 0.0, m_sampleRate) );
-    m_toneGenertors.push_back( std::make_unique<Sawtooth>(440, 0.0, m_sampleRate) );
-    m_toneGenertors.push_back( std::make_unique<Triangle>(440, 0.0, m_sampleRate) );
+    assert(hopSize >= FFTSize / 8 && hopSize <= FFTSize && "Argument \"hopSize\" has to be in [FFTSize / 8, FFTSize]!");
+    
+    m_toneGenertors.push_back( std::make_unique<Sinusoid>(initialFrequency, 0.0, m_sampleRate) );
+    m_toneGenertors.push_back( std::make_unique<Sawtooth>(initialFrequency, 0.0, m_sampleRate) );
+    m_toneGenertors.push_back( std::make_unique<Triangle>(initialFrequency, 0.0, m_sampleRate) );
+    
+    reset();
 }
 
 /**
@@ -48,132 +119,794 @@ SineWaveSpeech::SineWaveSpeech(std::size_t FFTSize, bool zeroPadAtEnd) :
  * \param samples    A vector of float samples normalized in the range [-1, 1]
  * \param sampleRate The sample rate of the samples
  *
- * \return A vector containing the generated sine wave speech sounds in the range [-1, 1]
+ * \return A vector of outputSize() samples containing the generated sine wave speech sounds in the range [-1, 1]
+ */
+std::vector<float> SineWaveSpeech::generateSineWaveSpeech(const std::vector<float>& samples, std::size_t sampleRate)
+{
+    std::vector<float> output(outputSize(samples.size()));
+    
+    generateSineWaveSpeech(samples.data(), samples.size(), sampleRate, output.data());
+    
+    return output;
+}
+
+
+/**
+ * \brief Generates the sine wave speech synthesis of a given input signal into the callers buffer.
+ *        The input is only read, the zero padding at its end is never allocated.
+ *
+ * \param samples         numberOfSamples float samples normalized in the range [-1, 1]
+ * \param numberOfSamples The length of the input
+ * \param sampleRate      The sample rate of the samples
+ * \param output          outputSize(numberOfSamples) samples, must not overlap the input
+ */
+void SineWaveSpeech::generateSineWaveSpeech(const float* samples, std::size_t numberOfSamples, std::size_t sampleRate, float* output)
+{
+    assert((output + outputSize(numberOfSamples) <= samples || samples + numberOfSamples <= output) && "Argument \"output\" must not overlap the input!");
+    
+    generate(samples, numberOfSamples, sampleRate, output);
+}
+
+
+/**
+ * \brief Generates the sine wave speech of 16 bit samples, e.g. straight from a WAV file, into the callers buffer.
+ *        Every frame is scaled and windowed in one pass, the output is the same as for the samples
+ *        converted to floats by n / 32768.
+ */
+void SineWaveSpeech::generateSineWaveSpeech(const std::int16_t* samples, std::size_t numberOfSamples, std::size_t sampleRate, float* output)
+{
+    generate(samples, numberOfSamples, sampleRate, output);
+}
+
+
+template<typename Sample>
+void SineWaveSpeech::generate(const Sample* samples, std::size_t numberOfSamples, std::size_t sampleRate, float* output)
+{
+    const std::size_t size = outputSize(numberOfSamples);
+    
+    this->sampleRate(sampleRate);
+    m_parameterChannel.read(m_parameters);
+    
+    // the frames only cover the output up to the last full hop and the inverse FFT adds into it
+    std::fill_n(output, size, 0.f);
+    
+    if (m_pipelineDepth > 0)
+    {
+        generatePipelined(samples, numberOfSamples, output);
+    }
+    else
+    {
+        analyseFrames(samples, numberOfSamples);
+        
+        generateSineWaveSound(output);
+    }
+}
+
+
+/**
+ * \brief Renders a score, no FFT is computed. The glide, tone generator and synthesis come from
+ *        the current parameters(), so the same score can be rendered in many ways.
+ *
+ * \param score      The analysis of a signal, from analyse() or SineWaveScore::loadFromFile().
+ *                   It has to be analysed with the FFTSize of this instance.
+ * \param sampleRate The sample rate of the output. If it differs from the rate of the score,
+ *                   the hopSize of this instance has to be the hop of the score at the new rate,
+ *                   e.g. a score analysed at 16 kHz with a hop of 128 is rendered at 48 kHz with a hop of 384.
+ *
+ * \return The sine wave speech, as long as the analysed signal at the new rate.
+ *         Empty if the score doesn't fit this instance, the reason is printed.
+ */
+std::vector<float> SineWaveSpeech::generateSineWaveSpeech(const SineWaveScore& score, std::size_t sampleRate)
+{
+    // scores come from files, so they are checked like one
+    if (score.FFTSize() != m_FFTSize)
+    {
+        std::cerr << "The score was analysed with an FFT size of " << score.FFTSize() << ", not " << m_FFTSize << "." << std::endl;
+        return std::vector<float>();
+    }
+    if (score.sampleRate() == 0 || m_hopSize * score.sampleRate() != score.hopSize() * sampleRate)
+    {
+        std::cerr << "The hop size of the score at " << sampleRate << " Hz is not " << m_hopSize << "." << std::endl;
+        return std::vector<float>();
+    }
+    
+    // only the first track of every frame is synthesized
+    m_frames.resize(score.numberOfFrames());
+    for (std::size_t i = 0; i < m_frames.size(); ++i)
+    {
+        m_frames[i].bin = score.frame(i)->bin;
+        m_frames[i].rms = score.frame(i)->rms;
+        
+        if (m_frames[i].bin >= m_FFTSize / 2)
+        {
+            std::cerr << "Frame " << i << " of the score has a bin outside of the spectrum." << std::endl;
+            return std::vector<float>();
+        }
+    }
+    
+    this->sampleRate(sampleRate, score.sampleRate());
+    m_parameterChannel.read(m_parameters);
+    
+    // the inverse FFT writes FFTSize samples for the last frame, which doesn't scale with the rate
+    const std::size_t numberOfSamples = score.numberOfSamples() * sampleRate / score.sampleRate();
+    const std::size_t synthesizedSamples = m_frames.empty() ? 0 : (m_frames.size() - 1) * m_hopSize + m_FFTSize;
+    
+    std::vector<float> output(std::max(numberOfSamples, synthesizedSamples));
+    
+    generateSineWaveSound(output.data());
+    
+    output.resize(numberOfSamples);
+    
+    return output;
+}
+
+
+/**
+ * \brief Analyses a signal into a score without synthesizing it. The frames are padded and
+ *        analysed just like in generateSineWaveSpeech(), also on the workerPool().
+ *
+ * \param samples    A vector of float samples normalized in the range [-1, 1]
+ * \param sampleRate The sample rate of the samples
+ */
+SineWaveScore SineWaveSpeech::analyse(const std::vector<float>& samples, std::size_t sampleRate)
+{
+    assert(m_FFTSize <= SineWaveScore::maximumFFTSize && "The bins of this FFT size do not fit into a score!");
+
+    this->sampleRate(sampleRate);
+    
+    analyseFrames(samples.data(), samples.size());
+    
+    SineWaveScore score(sampleRate, m_FFTSize, m_hopSize, outputSize(samples.size()));
+    for (const auto& frame: m_frames)
+    {
+        const SineWaveScore::Track track = { static_cast<std::uint16_t>(frame.bin), frame.rms };
+        score.addFrame(&track);
+    }
+    
+    return score;
+}
+
+
+/**
+ * \brief Sets the sample rate of the input and output. Has to be called before processBlock().
+ */
+void SineWaveSpeech::sampleRate(std::size_t sampleRate)
+{
+    this->sampleRate(sampleRate, sampleRate);
+}
+
+
+/**
+ * \brief Sets the sample rate of the output and the rate the bins of the frames refer to.
  */
-std::vector<float> SineWaveSpeech::generateSineWaveSpeech(std::vector<float> samples, std::size_t sampleRate)
+void SineWaveSpeech::sampleRate(std::size_t sampleRate, std::size_t analysisSampleRate)
 {
     m_sampleRate = sampleRate;
+    m_analysisSampleRate = analysisSampleRate;
     
     for(auto& t: m_toneGenertors)
         t->sampleRate = m_sampleRate;
     
-    if (m_zeroPadAtEnd)
-    {
-        // make sure it can always be devided through FFTSize without remainder, if necessary add 0's
-        auto remainder = m_FFTSize - (samples.size() % m_FFTSize);
-        samples.insert(samples.end(), remainder, 0.f);
-    }
+    // the table only changes with the sample rates, so most calls don't touch the shared cache
+    if (!m_oscillatorTable || m_oscillatorTable->sampleRate() != m_sampleRate || m_oscillatorTable->analysisSampleRate() != m_analysisSampleRate)
+        m_oscillatorTable = OscillatorTable::get(m_sampleRate, m_FFTSize / 2, m_analysisSampleRate);
+}
+
+
+/**
+ * \brief The own workspace, the whole signal methods create it if the instance was made without.
+ */
+SineWaveSpeech::Workspace& SineWaveSpeech::workspace()
+{
+    if (!m_workspace)
+        m_workspace = std::make_unique<Workspace>(m_FFTSize);
     
-    // TODO: check this
-    m_outputSamples.clear();
-    m_outputSamples.resize(samples.size());
+    return *m_workspace;
+}
+
+
+/**
+ * \brief Streams a block of samples through the synthesis. Every hop of input is analysed and
+ *        synthesized exactly once, no matter how the input is split into blocks. The output is
+ *        the same as generateSineWaveSpeech() delayed by latency() samples.
+ *
+ * \param in  n input samples normalized in the range [-1, 1]
+ * \param out n output samples, may be the same buffer as in
+ * \param n   The number of samples, can be anything
+ *
+ * All buffers are allocated by the constructor and sampleRate(), this doesn't allocate memory
+ * or take locks, so it is safe to call from a real-time audio thread.
+ * Changed parameters() take effect at the start of the next block.
+ */
+void SineWaveSpeech::processBlock(const float* in, float* out, std::size_t n)
+{
+    assert(m_workspace && "Without an own workspace every block has to bring one!");
     
-    generateMagnitudeSpecta(samples, sampleRate);
+    processBlock(in, out, n, *m_workspace);
+}
+
+
+/**
+ * \brief Streams a block with the scratch memory of the caller, see processBlock() above.
+ *
+ * \param workspace Made for the FFTSize of this instance, only used during the call
+ */
+void SineWaveSpeech::processBlock(const float* in, float* out, std::size_t n, Workspace& workspace)
+{
+    assert(!m_inputRing.empty() && "The input was switched to 16 bit by int16Input()!");
     
-    generateSineWaveSound();
+    stream(in, m_inputRing, out, n, workspace);
+}
+
+
+/**
+ * \brief Streams a block of 16 bit samples, e.g. straight from a WAV file, see processBlock() above.
+ *        Every frame is scaled and windowed in one pass, the output is the same as for the samples
+ *        converted to floats by n / 32768. Only after int16Input(true).
+ */
+void SineWaveSpeech::processBlock(const std::int16_t* in, float* out, std::size_t n)
+{
+    assert(m_workspace && "Without an own workspace every block has to bring one!");
     
-    return m_outputSamples;
+    processBlock(in, out, n, *m_workspace);
 }
 
 
-void SineWaveSpeech::generateMagnitudeSpecta(std::vector<float>& samples, std::size_t sampleRate)
+void SineWaveSpeech::processBlock(const std::int16_t* in, float* out, std::size_t n, Workspace& workspace)
 {
-    // calculate how many times the FFT will be called
-    // -1 to avoid out of bounds reading on last iteration because of our 50% sliding window
-    const std::size_t numberOfRepeats = samples.size() / (m_FFTSize / 2) - 1;
+    assert(!m_int16InputRing.empty() && "The input has to be switched to 16 bit by int16Input()!");
     
-    m_magnitudes.clear();
-    m_magnitudes.reserve(numberOfRepeats);
+    stream(in, m_int16InputRing, out, n, workspace);
+}
+
+
+/**
+ * \brief Switches processBlock() between float and 16 bit input, the ring of the other one is freed.
+ *        Allocates and resets the stream, so call it before streaming, not from the audio thread.
+ */
+void SineWaveSpeech::int16Input(bool int16Input)
+{
+    std::vector<float>(int16Input ? 0 : m_FFTSize).swap(m_inputRing);
+    std::vector<std::int16_t>(int16Input ? m_FFTSize : 0).swap(m_int16InputRing);
     
-    m_rms.clear();
-    m_rms.reserve(numberOfRepeats);
+    reset();
+}
+
+
+template<typename Sample>
+void SineWaveSpeech::stream(const Sample* in, std::vector<Sample>& inputRing, float* out, std::size_t n, Workspace& workspace)
+{
+    m_parameterChannel.read(m_parameters);
     
-    auto chunckBegin = samples.cbegin();
-    for (int i = 0; i < numberOfRepeats; i++)
+    while (n > 0)
     {
-        std::vector<float> sampleChunck(m_FFTSize);
-        std::copy(chunckBegin, chunckBegin + m_FFTSize, sampleChunck.begin());
+        // never go past the next frame boundary
+        const std::size_t chunk = std::min(n, m_samplesUntilFrame);
         
-        m_magnitudeSpectrum.process(sampleChunck);
+        // write the input into the ring, wrapping around at most once
+        const std::size_t firstPart = std::min(chunk, m_FFTSize - m_inputPosition);
+        std::copy_n(in, firstPart, inputRing.begin() + m_inputPosition);
+        std::copy_n(in + firstPart, chunk - firstPart, inputRing.begin());
+        m_inputPosition = (m_inputPosition + chunk) % m_FFTSize;
         
-        m_magnitudes.push_back(m_magnitudeSpectrum.getMagnitudeSpectrum());
+        // read the output of the last frame, silence until the first frame is done
+        if (m_outputReady)
+        {
+            std::copy_n(m_synthesisBuffer.begin() + m_outputPosition, chunk, out);
+            m_outputPosition += chunk;
+        }
+        else
+        {
+            std::fill_n(out, chunk, 0.f);
+        }
         
-        // normalize FFT bins
-        std::transform(m_magnitudes.back().begin(), m_magnitudes.back().end(), m_magnitudes.back().begin(),
-                       [this](float bin)
-                       {
-                           return bin / (m_FFTSize / 2.f - 1);
-                       });
+        in += chunk;
+        out += chunk;
+        n -= chunk;
+        m_samplesUntilFrame -= chunk;
         
-        chunckBegin += m_FFTSize / 2;
+        if (m_samplesUntilFrame == 0)
+        {
+            processStreamFrame(workspace);
+            m_samplesUntilFrame = m_hopSize;
+        }
+    }
+}
+
+
+/**
+ * \brief Forgets all streamed input and output and the phases of the synthesis, e.g. before streaming
+ *        another signal. Afterwards the output is the same as that of a new instance.
+ */
+void SineWaveSpeech::reset()
+{
+    for (auto& toneGenerator: m_toneGenertors)
+        toneGenerator->reset(initialFrequency, 0.0);
+    m_spectralSynthesizer.reset(m_partials.size());
+    std::fill(m_partials.begin(), m_partials.end(), SpectralSynthesizer::Partial());
+    
+    std::fill(m_inputRing.begin(), m_inputRing.end(), 0.f);
+    std::fill(m_int16InputRing.begin(), m_int16InputRing.end(), 0);
+    std::fill(m_synthesisBuffer.begin(), m_synthesisBuffer.end(), 0.f);
+    m_inputPosition = 0;
+    m_samplesUntilFrame = m_FFTSize;    // the first frame needs a full window
+    m_outputPosition = 0;
+    m_outputReady = false;
+}
+
+
+/**
+ * \brief The delay of processBlock() in samples.
+ */
+std::size_t SineWaveSpeech::latency() const
+{
+    return m_FFTSize;
+}
+
+
+void SineWaveSpeech::processStreamFrame(Workspace& workspace)
+{
+    // the samples of the last frame have been played, move the overlap-add tail to the front
+    if (m_outputReady)
+    {
+        std::copy(m_synthesisBuffer.begin() + m_hopSize, m_synthesisBuffer.end(), m_synthesisBuffer.begin());
+        std::fill(m_synthesisBuffer.end() - m_hopSize, m_synthesisBuffer.end(), 0.f);
+    }
+    
+    if (m_int16InputRing.empty())
+        unwrapRing(m_inputRing, m_inputPosition, workspace.frameSamples);
+    else
+        unwrapRing(m_int16InputRing, m_inputPosition, workspace.int16FrameSamples);
+    
+    Frame frame;
+    if (m_telemetry)
+    {
+        typedef std::chrono::steady_clock Clock;
         
-        // calculate the RMS of the sample block
-        double meansquare = std::sqrt( ( std::inner_product( sampleChunck.begin(), sampleChunck.end(), sampleChunck.begin(), 0.0 ) ) / static_cast<double>( sampleChunck.size() ) );
+        const auto start = Clock::now();
+        analyseStreamFrame(workspace, frame);
+        const auto analysed = Clock::now();
+        synthesizeFrame(frame, workspace.spectrum, m_synthesisBuffer.data());
+        const auto synthesized = Clock::now();
         
-        m_rms.push_back(meansquare);
+        m_telemetry->recordStage(Telemetry::Stage::Analysis, analysed - start);
+        m_telemetry->recordStage(Telemetry::Stage::Synthesis, synthesized - analysed);
+    }
+    else
+    {
+        analyseStreamFrame(workspace, frame);
+        synthesizeFrame(frame, workspace.spectrum, m_synthesisBuffer.data());
+    }
+    
+    m_outputPosition = 0;
+    m_outputReady = true;
+}
+
+
+/**
+ * \brief Analyses the unwrapped ring of the input processBlock() was switched to.
+ */
+void SineWaveSpeech::analyseStreamFrame(Workspace& workspace, Frame& frame) const
+{
+    if (m_int16InputRing.empty())
+        analyseFrame(workspace.magnitudeSpectrum, workspace.frameSamples.data(), frame);
+    else
+        analyseFrame(workspace.magnitudeSpectrum, workspace.int16FrameSamples.data(), frame);
+}
+
+
+/**
+ * \brief The length of the output of generateSineWaveSpeech() for an input of numberOfSamples.
+ *        With zeroPadAtEnd the input is padded with zeros, so the last frame is complete.
+ */
+std::size_t SineWaveSpeech::outputSize(std::size_t numberOfSamples) const
+{
+    // make sure it can always be devided through FFTSize without remainder, if necessary add 0's
+    return m_zeroPadAtEnd ? numberOfSamples + m_FFTSize - (numberOfSamples % m_FFTSize) : numberOfSamples;
+}
+
+
+/**
+ * \brief How many times the FFT will be called for a signal, the last frame has to fit completely.
+ */
+std::size_t SineWaveSpeech::numberOfFrames(std::size_t numberOfSamples) const
+{
+    return numberOfSamples < m_FFTSize ? 0 : (numberOfSamples - m_FFTSize) / m_hopSize + 1;
+}
+
+
+/**
+ * \brief Analyses every frame of the padded signal into m_frames, see outputSize().
+ */
+template<typename Sample>
+void SineWaveSpeech::analyseFrames(const Sample* samples, std::size_t numberOfSamples)
+{
+    const std::size_t numberOfRepeats = numberOfFrames(outputSize(numberOfSamples));
+    
+    m_frames.resize(numberOfRepeats);
+    
+    const std::size_t numberOfTiles = numberOfShards(numberOfRepeats);
+    if (numberOfTiles <= 1)
+    {
+        analyseTile(samples, numberOfSamples, 0, numberOfRepeats, workspace().magnitudeSpectrum);
+        return;
+    }
+    
+    // every frame only reads its own slice of the input, so each task analyses one contiguous
+    // tile of frames with its own FFT buffers and writes into its own part of m_frames
+    while (m_analysisSpectra.size() < numberOfTiles)
+        m_analysisSpectra.emplace_back(m_FFTSize, MagnitudeSpectrum::Range::ExcludeDC_IncludeNyquist);
+    
+    m_workerPool->run(numberOfTiles, [&](std::size_t tile)
+                      {
+                          analyseTile(samples, numberOfSamples, numberOfRepeats * tile / numberOfTiles,
+                                      numberOfRepeats * (tile + 1) / numberOfTiles, m_analysisSpectra[tile]);
+                      });
+}
+
+
+/**
+ * \brief How many parts the frames are split into for the workerPool(), 1 without one.
+ */
+std::size_t SineWaveSpeech::numberOfShards(std::size_t numberOfFrames) const
+{
+    if (!m_workerPool)
+        return 1;
+    
+    return std::max<std::size_t>(1, std::min(shardsPerThread * m_workerPool->numberOfThreads(), numberOfFrames / minimumShardFrames));
+}
+
+
+/**
+ * \brief Analyses the frames [firstFrame, lastFrame) of samples into m_frames.
+ */
+template<typename Sample>
+void SineWaveSpeech::analyseTile(const Sample* samples, std::size_t numberOfSamples, std::size_t firstFrame, std::size_t lastFrame, MagnitudeSpectrum& magnitudeSpectrum)
+{
+    for (std::size_t i = firstFrame; i < lastFrame; ++i)
+        analyseFrameAt(magnitudeSpectrum, samples, numberOfSamples, i, m_frames[i]);
+}
+
+
+/**
+ * \brief Analyses frame index of the signal, the samples after numberOfSamples are zeros.
+ */
+template<typename Sample>
+void SineWaveSpeech::analyseFrameAt(MagnitudeSpectrum& magnitudeSpectrum, const Sample* samples, std::size_t numberOfSamples, std::size_t index, Frame& frame) const
+{
+    const std::size_t start = index * m_hopSize;
+    
+    // the frames are analysed in place, the window is applied while reading them
+    if (start + m_FFTSize <= numberOfSamples)
+    {
+        analyseFrame(magnitudeSpectrum, samples + start, frame);
+        return;
     }
+    
+    // the frame reaches into the zero padding, which only exists here. At most FFTSize / hopSize frames of a signal do
+    std::vector<Sample> padded(m_FFTSize, 0);
+    if (start < numberOfSamples)
+        std::copy(samples + start, samples + numberOfSamples, padded.begin());
+    
+    analyseFrame(magnitudeSpectrum, padded.data(), frame);
+}
+
+
+/**
+ * \brief Analyses the FFTSize samples starting at samples.
+ */
+void SineWaveSpeech::analyseFrame(MagnitudeSpectrum& magnitudeSpectrum, const float* samples, Frame& frame) const
+{
+    magnitudeSpectrum.process(samples);
+    
+    // find the highest amplitude
+    const auto& magnitudes = magnitudeSpectrum.getMagnitudeSpectrum();
+    frame.bin = std::distance(magnitudes.begin(), std::max_element(magnitudes.begin(), magnitudes.end()));
+    
+    // calculate the RMS of the sample block
+    frame.rms = std::sqrt( ( std::inner_product( samples, samples + m_FFTSize, samples, 0.0 ) ) / static_cast<double>( m_FFTSize ) );
+}
+
+
+/**
+ * \brief Analyses FFTSize 16 bit samples, the result is the same as for the samples converted to floats.
+ */
+void SineWaveSpeech::analyseFrame(MagnitudeSpectrum& magnitudeSpectrum, const std::int16_t* samples, Frame& frame) const
+{
+    magnitudeSpectrum.process(samples);
+    
+    const auto& magnitudes = magnitudeSpectrum.getMagnitudeSpectrum();
+    frame.bin = std::distance(magnitudes.begin(), std::max_element(magnitudes.begin(), magnitudes.end()));
+    
+    // sums the float squares like the inner product above
+    double sum = 0.0;
+    for (std::size_t i = 0; i < m_FFTSize; ++i)
+    {
+        const float sample = samples[i] * PCM::int16Scale;
+        sum += sample * sample;
+    }
+    frame.rms = std::sqrt( sum / static_cast<double>( m_FFTSize ) );
+}
+
+
+/**
+ * \brief Changes the parameters while audio is running. The new set is handed to the audio thread
+ *        as a whole, so a block never sees half of an update. The audio thread picks it up at the
+ *        start of the next processBlock() or generateSineWaveSpeech() call.
+ *
+ * Only one control thread may change the parameters.
+ */
+void SineWaveSpeech::parameters(const Parameters& parameters)
+{
+    assert(parameters.toneGenerator < m_toneGenertors.size() && "Argument \"toneGenerator\" is not a tone generator!");
+    
+    m_controlParameters = parameters;
+    m_controlParameters.glideSteps = std::max<std::size_t>(1, std::min(parameters.glideSteps, m_hopSize));
+    
+    m_parameterChannel.write(m_controlParameters);
+}
+
+
+/**
+ * \brief The parameters last set by the control thread, not necessarily in use by the audio thread yet.
+ */
+const SineWaveSpeech::Parameters& SineWaveSpeech::parameters() const
+{
+    return m_controlParameters;
 }
 
 
 void SineWaveSpeech::nextToneGenerator()
 {
-    ++m_currentToneGenerator;
-    m_currentToneGenerator = m_currentToneGenerator % m_toneGenertors.size();
+    Parameters parameters = m_controlParameters;
+    parameters.toneGenerator = (parameters.toneGenerator + 1) % m_toneGenertors.size();
+    this->parameters(parameters);
 }
 
 
-void SineWaveSpeech::generateSineWaveSound()
+/**
+ * \brief Selects how the sine wave speech is rendered. Can be changed while audio is running.
+ */
+void SineWaveSpeech::synthesis(Synthesis synthesis)
 {
-    const float numberOfBins = m_magnitudeSpectrum.numberOfBins();
-    const float bandwidth = m_sampleRate / 2.f / numberOfBins;
-    const float middleFrequency = bandwidth / 2.f;
+    Parameters parameters = m_controlParameters;
+    parameters.synthesis = synthesis;
+    this->parameters(parameters);
+}
+
+
+/**
+ * \brief Times the analysis and synthesis of every streamed frame, nullptr to stop.
+ *        Set it before streaming starts, the pointer itself isn't synchronised.
+ */
+void SineWaveSpeech::telemetry(Telemetry* telemetry)
+{
+    m_telemetry = telemetry;
+}
+
+
+/**
+ * \brief Analyses and synthesizes the frames of generateSineWaveSpeech() in shards on the given
+ *        pool, nullptr to process them on the calling thread. The oscillators of one frame continue
+ *        the phase of the previous one, so the state at the start of every shard is computed first,
+ *        the output is the same as without a pool. The pool can be shared by any number of
+ *        instances, also ones that run in tasks of the same pool.
+ */
+void SineWaveSpeech::workerPool(WorkerPool* workerPool)
+{
+    m_workerPool = workerPool;
+}
+
+
+/**
+ * \brief Lets generateSineWaveSpeech() analyse on a second thread while it synthesizes,
+ *        instead of analysing the whole signal first. At most numberOfFrames analysed frames
+ *        wait for the synthesis, 0 turns the pipeline off. The analysis then runs on that one
+ *        thread, a workerPool() is not used.
+ */
+void SineWaveSpeech::pipelineDepth(std::size_t numberOfFrames)
+{
+    m_pipelineDepth = numberOfFrames;
+}
+
+
+/**
+ * \brief Synthesizes m_frames into output, which has to be zeros.
+ */
+void SineWaveSpeech::generateSineWaveSound(float* output)
+{
+    const std::size_t shards = numberOfShards(m_frames.size());
+    if (shards > 1)
+    {
+        generateShards(shards, output);
+        return;
+    }
     
-    int x = 0;
-    std::size_t currentBlock = 0;
+    std::vector<std::complex<float>>& spectrum = workspace().spectrum;
+    for (const auto& frame: m_frames)
+    {
+        synthesizeFrame(frame, spectrum, output);
+        output += m_hopSize;
+    }
+}
+
+
+/**
+ * \brief Synthesizes contiguous shards of m_frames in parallel on the worker pool, bit for bit
+ *        the same as one frame after the other.
+ */
+void SineWaveSpeech::generateShards(std::size_t numberOfShards, float* output)
+{
+    const std::size_t frames = m_frames.size();
+    const bool inverseFFT = usesInverseFFT();
+    
+    // the inverse FFT overlap-adds FFTSize samples, so the first samples of a shard also get the
+    // tails of the frames before it. The shard renders them again in serial order, so every sample
+    // is summed in the same order as without shards
+    const std::size_t overlap = inverseFFT ? (m_FFTSize + m_hopSize - 1) / m_hopSize - 1 : 0;
     
-    for (auto& mag: m_magnitudes)
+    auto firstFrame = [&](std::size_t shard) { return frames * shard / numberOfShards; };
+    auto startFrame = [&](std::size_t shard) { return firstFrame(shard) - std::min(overlap, firstFrame(shard)); };
+    
+    // stitch the shards together: the state only depends on the frames, not on the samples, so
+    // one serial pass over the frames finds the phase every shard starts with
+    std::vector<SynthesisState> states;
+    SynthesisState state = { m_toneGenertors[m_parameters.toneGenerator]->clone(), m_spectralSynthesizer, m_partials };
+    
+    for (std::size_t shard = 0, frame = 0; shard < numberOfShards; ++shard)
     {
-        // find the highest amplitude
-        auto highestAmp = std::max_element(mag.begin(), mag.end());
+        for (; frame < startFrame(shard); ++frame)
+            advanceFrame(m_frames[frame], *state.toneGenerator, state.spectralSynthesizer, state.partials);
         
-        // calculate the frequency
-        unsigned int index = std::distance(mag.begin(), highestAmp);
-        float frequency = middleFrequency + bandwidth * index;
+        states.push_back( SynthesisState{ state.toneGenerator->clone(), state.spectralSynthesizer, state.partials } );
+    }
+    
+    m_workerPool->run(numberOfShards, [&](std::size_t shard)
+                      {
+                          const std::size_t first = firstFrame(shard);
+                          const std::size_t last = firstFrame(shard + 1);
+                          const std::size_t start = startFrame(shard);
+                          SynthesisState& shardState = states[shard];
+                          std::vector<std::complex<float>> spectrum(inverseFFT ? m_FFTSize : 0);
+                          
+                          if (!inverseFFT)
+                          {
+                              // every frame writes its own hop, straight into the output
+                              for (std::size_t i = first; i < last; ++i)
+                                  synthesizeFrame(m_frames[i], *shardState.toneGenerator, shardState.spectralSynthesizer,
+                                                  shardState.partials, spectrum, output + i * m_hopSize);
+                              return;
+                          }
+                          
+                          // the shard owns the samples up to the next shard, the last one also the tail of its last frame
+                          std::vector<float> buffer((last - 1 - start) * m_hopSize + m_FFTSize);
+                          for (std::size_t i = start; i < last; ++i)
+                              synthesizeFrame(m_frames[i], *shardState.toneGenerator, shardState.spectralSynthesizer,
+                                              shardState.partials, spectrum, buffer.data() + (i - start) * m_hopSize);
+                          
+                          const std::size_t end = shard + 1 == numberOfShards ? buffer.size() : (last - start) * m_hopSize;
+                          std::copy(buffer.begin() + (first - start) * m_hopSize, buffer.begin() + end,
+                                    output + first * m_hopSize);
+                      });
+    
+    // the last shard ends in the state the serial synthesis would, continue from there
+    m_toneGenertors[m_parameters.toneGenerator] = std::move(states.back().toneGenerator);
+    m_spectralSynthesizer = states.back().spectralSynthesizer;
+}
+
+
+/**
+ * \brief Whether the frames are rendered with the inverse FFT, its overlap-add needs at least 50% overlap.
+ */
+bool SineWaveSpeech::usesInverseFFT() const
+{
+    return m_parameters.synthesis == Synthesis::InverseFFT && m_hopSize <= m_FFTSize / 2;
+}
+
+
+/**
+ * \brief Synthesizes one frame. The tone generators write hopSize samples,
+ *        the inverse FFT overlap-adds FFTSize samples.
+ */
+void SineWaveSpeech::synthesizeFrame(const Frame& frame, std::vector<std::complex<float>>& spectrum, float* output)
+{
+    synthesizeFrame(frame, *m_toneGenertors[m_parameters.toneGenerator], m_spectralSynthesizer, m_partials, spectrum, output);
+}
+
+
+/**
+ * \brief Synthesizes one frame with the given synthesis state.
+ *
+ * \param spectrum The scratch memory of the inverse FFT, FFTSize values if it is used
+ */
+void SineWaveSpeech::synthesizeFrame(const Frame& frame, ToneGenerator& toneGenerator, SpectralSynthesizer& spectralSynthesizer,
+                                     std::vector<SpectralSynthesizer::Partial>& partials, std::vector<std::complex<float>>& spectrum, float* output) const
+{
+    const float numberOfBins = m_FFTSize / 2;
+    const float bandwidth = m_analysisSampleRate / 2.f / numberOfBins;
+    const float middleFrequency = bandwidth / 2.f;
+    
+    // calculate the frequency
+    float frequency = middleFrequency + bandwidth * frame.bin;
+    
+    if (usesInverseFFT())
+    {
+        // the frame covers the whole analysis window, a muted frame keeps the partials phase running
+        const bool muted = frequency > m_parameters.cutoffFrequency;
+        partials[0].frequency = frequency;
+        partials[0].amplitude = muted ? 0.f : std::min(frame.rms * m_parameters.amplitudeScale, 1.f);
         
-        if (frequency > 3000)
-        {
-            std::fill_n(m_outputSamples.begin() + x, 256, 0.f);
-        }
-        else
-        {
-            float amplitude = std::min(m_rms[currentBlock] * std::sqrt(2.f), 1.f); // clamp to 1, because sometimes
-            const auto& toneGenertor = m_toneGenertors[m_currentToneGenerator];
-            
-            int interpolationSteps = 50;
-            double oldFrequency = toneGenertor->frequency();
-            double oldAmplitude = toneGenertor->amplitude();
-
-            double frequencyStep = (frequency - oldFrequency) / interpolationSteps;
-            double amplitudeStep = (amplitude - oldAmplitude) / interpolationSteps;
+        spectralSynthesizer.synthesizeFrame(partials, m_sampleRate, spectrum, output);
+    }
+    else if (frequency > m_parameters.cutoffFrequency)
+    {
+        std::fill_n(output, m_hopSize, 0.f);
+    }
+    else
+    {
+        float amplitude = std::min(frame.rms * m_parameters.amplitudeScale, 1.f); // clamp to 1, because sometimes
         
-            for (int i = 0; i < 256; i++)
-            {
-                if (i < interpolationSteps)
-                {
-                    toneGenertor->frequency(toneGenertor->frequency() + frequencyStep);
-                    toneGenertor->amplitude(toneGenertor->amplitude() + amplitudeStep);
-                }
-                else if (i == interpolationSteps)
-                {
-                    toneGenertor->frequency(frequency);
-                    toneGenertor->amplitude(amplitude);
-                }
-                
-                m_outputSamples[x + i] = toneGenertor->getNextSample();
-            }
-        }
+        toneGenerator.render(output, m_hopSize, m_oscillatorTable->bin(frame.bin), amplitude, m_parameters.glideSteps);
+    }
+}
+
+
+/**
+ * \brief Moves the synthesis state over one frame without rendering it, like synthesizeFrame() would.
+ */
+void SineWaveSpeech::advanceFrame(const Frame& frame, ToneGenerator& toneGenerator, SpectralSynthesizer& spectralSynthesizer,
+                                  std::vector<SpectralSynthesizer::Partial>& partials) const
+{
+    const float numberOfBins = m_FFTSize / 2;
+    const float bandwidth = m_analysisSampleRate / 2.f / numberOfBins;
+    const float middleFrequency = bandwidth / 2.f;
+    
+    float frequency = middleFrequency + bandwidth * frame.bin;
+    
+    if (usesInverseFFT())
+    {
+        partials[0].frequency = frequency;
+        spectralSynthesizer.advance(partials, m_sampleRate);
+    }
+    else if (frequency <= m_parameters.cutoffFrequency)
+    {
+        float amplitude = std::min(frame.rms * m_parameters.amplitudeScale, 1.f);
         
-        x += m_FFTSize / 2;
-        currentBlock++;
+        toneGenerator.advance(m_hopSize, m_oscillatorTable->bin(frame.bin), amplitude, m_parameters.glideSteps);
     }
 }
+
+
+/**
+ * \brief Analyses samples on its own thread and synthesizes every frame as soon as it arrives.
+ *        The analysis is held back when it is m_pipelineDepth frames ahead, so no frame matrix is kept.
+ */
+template<typename Sample>
+void SineWaveSpeech::generatePipelined(const Sample* samples, std::size_t numberOfSamples, float* output)
+{
+    BoundedQueue<Frame> frames(m_pipelineDepth);
+    
+    // the synthesis only uses the spectrum of the workspace, so the analysis thread can have the FFT buffers
+    Workspace& workspace = this->workspace();
+    std::thread analysis([&]()
+                         {
+                             const std::size_t numberOfRepeats = numberOfFrames(outputSize(numberOfSamples));
+                             
+                             Frame frame;
+                             for (std::size_t i = 0; i < numberOfRepeats; ++i)
+                             {
+                                 analyseFrameAt(workspace.magnitudeSpectrum, samples, numberOfSamples, i, frame);
+                                 frames.push(frame);
+                             }
+                             frames.close();
+                         });
+    
+    Frame frame;
+    while (frames.pop(frame))
+    {
+        synthesizeFrame(frame, workspace.spectrum, output);
+        output += m_hopSize;
+    }
+    
+    analysis.join();
+}
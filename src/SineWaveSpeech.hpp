@@ -24,35 +24,158 @@
 #define SINEWAVESPEECH_HPP
 
 #include <vector>
-#include <atomic>
 #include <memory>
+#include <cstdint>
 
 #include "MagnitudeSpectrum.hpp"
 #include "ToneGenerator.hpp"
+#include "OscillatorTable.hpp"
+#include "SpectralSynthesizer.hpp"
+#include "SineWaveScore.hpp"
+#include "TripleBuffer.hpp"
+
+class Telemetry;
+class WorkerPool;
 
 class SineWaveSpeech
 {
 public:
     
+    // define how the sine wave speech is rendered
+    enum class Synthesis
+    {
+        ToneGenerator,  // time domain oscillators, supports all tone generators
+        InverseFFT      // inverse FFT and overlap-add, sine waves only
+    };
+    
+    // the settings that can be tuned while audio is running
+    struct Parameters
+    {
+        float        cutoffFrequency;   // frames above this frequency are muted
+        float        amplitudeScale;    // from frame RMS to sine amplitude, sqrt(2) keeps the RMS
+        std::size_t  glideSteps;        // limited to hopSize
+        unsigned int toneGenerator;     // 0 sinusoid, 1 sawtooth, 2 triangle
+        Synthesis    synthesis;
+    };
+    
+    // the scratch memory of analysing and synthesizing a frame, nothing in it outlives a call,
+    // so instances that never run at the same time, e.g. on one worker thread, can share one
+    struct Workspace
+    {
+        explicit Workspace(std::size_t FFTSize);
+        
+        MagnitudeSpectrum                 magnitudeSpectrum;
+        std::vector<float>                frameSamples;         // the unwrapped input ring
+        std::vector<std::int16_t>         int16FrameSamples;    // the same for 16 bit input
+        std::vector<std::complex<float>>  spectrum;             // of the inverse FFT synthesis
+    };
+    
+    
     SineWaveSpeech(std::size_t FFTSize, bool zeroPadAtEnd);
+    SineWaveSpeech(std::size_t FFTSize, std::size_t hopSize, std::size_t glideSteps, bool zeroPadAtEnd, bool ownWorkspace = true);
+    
+    std::vector<float> generateSineWaveSpeech(const std::vector<float>& samples, std::size_t sampleRate);
+    void               generateSineWaveSpeech(const float* samples, std::size_t numberOfSamples, std::size_t sampleRate, float* output);
+    void               generateSineWaveSpeech(const std::int16_t* samples, std::size_t numberOfSamples, std::size_t sampleRate, float* output);
+    std::vector<float> generateSineWaveSpeech(const SineWaveScore& score, std::size_t sampleRate);
+    SineWaveScore      analyse(const std::vector<float>& samples, std::size_t sampleRate);
+    std::size_t        outputSize(std::size_t numberOfSamples) const;
+    
+    void        sampleRate(std::size_t sampleRate);
+    void        processBlock(const float* in, float* out, std::size_t n);
+    void        processBlock(const float* in, float* out, std::size_t n, Workspace& workspace);
+    void        processBlock(const std::int16_t* in, float* out, std::size_t n);
+    void        processBlock(const std::int16_t* in, float* out, std::size_t n, Workspace& workspace);
+    void        int16Input(bool int16Input);
+    void        reset();
+    std::size_t latency() const;
+    
+    void              parameters(const Parameters& parameters);
+    const Parameters& parameters() const;
     
-    std::vector<float> generateSineWaveSpeech(std::vector<float> samples, std::size_t sampleRate);
     void nextToneGenerator();
+    void synthesis(Synthesis synthesis);
+    
+    void telemetry(Telemetry* telemetry);
+    void workerPool(WorkerPool* workerPool);
+    void pipelineDepth(std::size_t numberOfFrames);
     
 private:
     
-    void generateMagnitudeSpecta(std::vector<float>& samples, std::size_t sampleRate);
-    void generateSineWaveSound();
+    // the analysis result of one frame
+    struct Frame
+    {
+        std::size_t bin;    // the bin with the highest magnitude
+        float       rms;
+    };
+    
+    // the synthesis state that continues from frame to frame, a shard of the frames starts from a copy
+    struct SynthesisState
+    {
+        std::unique_ptr<ToneGenerator>             toneGenerator;
+        SpectralSynthesizer                        spectralSynthesizer;
+        std::vector<SpectralSynthesizer::Partial>  partials;
+    };
+    
+    void        sampleRate(std::size_t sampleRate, std::size_t analysisSampleRate);
+    Workspace&  workspace();
+    std::size_t numberOfFrames(std::size_t numberOfSamples) const;
+    std::size_t numberOfShards(std::size_t numberOfFrames) const;
+    template<typename Sample>
+    void generate(const Sample* samples, std::size_t numberOfSamples, std::size_t sampleRate, float* output);
+    template<typename Sample>
+    void analyseFrames(const Sample* samples, std::size_t numberOfSamples);
+    template<typename Sample>
+    void analyseTile(const Sample* samples, std::size_t numberOfSamples, std::size_t firstFrame, std::size_t lastFrame, MagnitudeSpectrum& magnitudeSpectrum);
+    template<typename Sample>
+    void analyseFrameAt(MagnitudeSpectrum& magnitudeSpectrum, const Sample* samples, std::size_t numberOfSamples, std::size_t index, Frame& frame) const;
+    void analyseFrame(MagnitudeSpectrum& magnitudeSpectrum, const float* samples, Frame& frame) const;
+    void analyseFrame(MagnitudeSpectrum& magnitudeSpectrum, const std::int16_t* samples, Frame& frame) const;
+    void generateSineWaveSound(float* output);
+    template<typename Sample>
+    void generatePipelined(const Sample* samples, std::size_t numberOfSamples, float* output);
+    void generateShards(std::size_t numberOfShards, float* output);
+    bool usesInverseFFT() const;
+    void synthesizeFrame(const Frame& frame, std::vector<std::complex<float>>& spectrum, float* output);
+    void synthesizeFrame(const Frame& frame, ToneGenerator& toneGenerator, SpectralSynthesizer& spectralSynthesizer,
+                         std::vector<SpectralSynthesizer::Partial>& partials, std::vector<std::complex<float>>& spectrum, float* output) const;
+    void advanceFrame(const Frame& frame, ToneGenerator& toneGenerator, SpectralSynthesizer& spectralSynthesizer,
+                      std::vector<SpectralSynthesizer::Partial>& partials) const;
+    template<typename Sample>
+    void stream(const Sample* in, std::vector<Sample>& inputRing, float* out, std::size_t n, Workspace& workspace);
+    void processStreamFrame(Workspace& workspace);
+    void analyseStreamFrame(Workspace& workspace, Frame& frame) const;
     
     std::size_t                                    m_FFTSize;
-    MagnitudeSpectrum                              m_magnitudeSpectrum;
+    std::size_t                                    m_hopSize;
     std::size_t                                    m_sampleRate;
-    std::vector<std::vector<float>>                m_magnitudes;
-    std::vector<float>                             m_outputSamples;
-    std::vector<float>                             m_rms;
-    std::atomic<unsigned int>                      m_currentToneGenerator;
+    std::size_t                                    m_analysisSampleRate;  // differs from m_sampleRate when a score is rendered at another rate
+    std::vector<Frame>                             m_frames;
     std::vector<std::unique_ptr<ToneGenerator>>    m_toneGenertors;
     bool                                           m_zeroPadAtEnd;
+    std::shared_ptr<const OscillatorTable>         m_oscillatorTable;
+    SpectralSynthesizer                            m_spectralSynthesizer;
+    std::vector<SpectralSynthesizer::Partial>      m_partials;
+    WorkerPool*                                    m_workerPool;
+    std::vector<MagnitudeSpectrum>                 m_analysisSpectra;     // one per shard, so the workers never share FFT buffers
+    std::size_t                                    m_pipelineDepth;
+    std::unique_ptr<Workspace>                     m_workspace;           // for processBlock() without a workspace and the whole signal methods
+    
+    // the control thread edits m_controlParameters and publishes them through the channel,
+    // the audio thread picks them up into m_parameters at the start of every block
+    Parameters                                     m_controlParameters;
+    TripleBuffer<Parameters>                       m_parameterChannel;
+    Parameters                                     m_parameters;
+    
+    // streaming state
+    std::vector<float>                             m_inputRing;
+    std::vector<std::int16_t>                      m_int16InputRing;      // instead of m_inputRing after int16Input()
+    std::size_t                                    m_inputPosition;
+    std::size_t                                    m_samplesUntilFrame;
+    std::vector<float>                             m_synthesisBuffer;
+    std::size_t                                    m_outputPosition;
+    bool                                           m_outputReady;
+    Telemetry*                                     m_telemetry;
 };
 
 
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+
+#include "SocketServer.hpp"
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+
+namespace
+{
+    SocketServer* server = nullptr;
+
+    void stopServer(int)
+    {
+        if (server)
+            server->stop();
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    std::size_t FFTSize = 512;
+    std::size_t hopSize = 0;
+    std::size_t numberOfThreads = 0;
+    std::string unixPath;
+    long port = -1;
+
+    int option;
+    while ((option = getopt(argc, argv, "u:p:n:h:j:")) != -1)
+    {
+        switch (option) {
+        case 'u':
+            unixPath = optarg;
+            break;
+        case 'p':
+            port = std::strtol(optarg, nullptr, 10);
+            break;
+        case 'n':
+            FFTSize = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'h':
+            hopSize = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'j':
+            numberOfThreads = std::strtoul(optarg, nullptr, 10);
+            break;
+        default:
+            std::cerr << "usage: " << argv[0] << " -u unix socket path | -p localhost TCP port"
+                      << " [-n FFT size] [-h hop size] [-j threads]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (unixPath.empty() == (port < 0))
+    {
+        std::cerr << "Give either a Unix socket path (-u) or a TCP port (-p)." << std::endl;
+        return 1;
+    }
+    if (port > 65535)
+    {
+        std::cerr << "The port has to be between 0 and 65535." << std::endl;
+        return 1;
+    }
+    if (FFTSize < 16 || (FFTSize & (FFTSize - 1)))
+    {
+        std::cerr << "The FFT size has to be a power of 2 and at least 16." << std::endl;
+        return 1;
+    }
+    if (hopSize == 0)
+        hopSize = FFTSize / 2;
+    if (hopSize < FFTSize / 8 || hopSize > FFTSize)
+    {
+        std::cerr << "The hop size has to be between FFT size / 8 and FFT size." << std::endl;
+        return 1;
+    }
+
+    SocketServer socketServer(FFTSize, hopSize, numberOfThreads);
+    if (!(unixPath.empty() ? socketServer.listenTCP(static_cast<std::uint16_t>(port)) : socketServer.listenUnix(unixPath)))
+        return 1;
+
+    server = &socketServer;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    socketServer.run();
+
+    server = nullptr;
+    return 0;
+}
@@ -23,13 +23,19 @@
 
 #include "ToneGenerator.hpp"
 
+#include <cassert>
+
 /*
  * \brief A sine wave generator. It uses matrix rotation as an optimization.
  *        See https://en.wikipedia.org/wiki/Rotation_matrix#In_two_dimensions
- *        Note this implementation is optimized for sinusoids whos frequency stays the
- *        same between calls to getNextSample(). If the frequency is changed between 
- *        every call to getNextSample() a naive implementation using std::sin() will be
- *        more efficent. Also note that the phase stays continous when the frequency changes.
+ *        The rotation is only efficient for sinusoids whos frequency stays the same between
+ *        calls to getNextSample(). While the frequency is changed between every call (e.g. during
+ *        a glide) the generator switches to a phase accumulator and a polynomial sine, which costs
+ *        the same no matter how often the frequency changes. When the frequency settles, the rotation
+ *        is restarted from the accumulated phase, which also renormalises it, so its amplitude
+ *        can't drift during long runs. Also note that the phase stays continous when the frequency changes.
+ *        render() computes the glide in closed form as a linear chirp, so every glide sample only
+ *        depends on its index and the loop can be vectorized.
  */
 
 class Sinusoid : public ToneGenerator
@@ -38,26 +44,132 @@ public:
     Sinusoid(double _frequency, double _amplitude, double _sampleRate) :
         ToneGenerator(_frequency, _amplitude, _sampleRate),
         m_x(0.0),
-        m_y(1.0)
+        m_y(1.0),
+        m_phase(0.0),
+        m_frequencyChanged(true),
+        m_accumulating(true),
+        m_samplesSinceSync(0)
     {
         frequency(_frequency);
     }
 
     double getNextSample() override
     {
+        if (m_frequencyChanged)
+        {
+            // ramp: the rotation coefficients would be stale after one sample anyway
+            m_frequencyChanged = false;
+            m_accumulating = true;
+            
+            const double sample = sine(m_phase);
+            advancePhase();
+            
+            return m_amplitude * sample;
+        }
+        
+        if (m_accumulating || m_samplesSinceSync >= renormalisationInterval)
+        {
+            // (re)start the rotation at the accumulated phase with a unit length vector
+            m_x = sine(m_phase);
+            m_y = sine(wrap(m_phase + PI / 2.0));
+            m_accumulating = false;
+            m_samplesSinceSync = 0;
+        }
+        
         double oldX = m_x;
         m_x = m_x * m_cosinus + m_y * m_sinus;
         m_y = oldX * -m_sinus + m_y * m_cosinus;
+        advancePhase();
+        m_samplesSinceSync++;
         
         return m_amplitude * oldX;
     }
     
+    std::unique_ptr<ToneGenerator> clone() const override
+    {
+        return std::make_unique<Sinusoid>(*this);
+    }
+    
+    void reset(double frequency, double amplitude) override
+    {
+        m_x = 0.0;
+        m_y = 1.0;
+        m_phase = 0.0;
+        m_accumulating = true;
+        m_samplesSinceSync = 0;
+        
+        ToneGenerator::reset(frequency, amplitude);
+    }
+    
     void frequency(double frequency) override
     {
         m_frequency = frequency;
-        double step = twoPI * m_frequency / sampleRate;
-        m_sinus = std::sin(step);
-        m_cosinus = std::cos(step);
+        m_step = sampleRate > 0.0 ? twoPI * m_frequency / sampleRate : 0.0;
+        m_sinus = std::sin(m_step);
+        m_cosinus = std::cos(m_step);
+        m_frequencyChanged = true;
+    }
+    
+    void frequency(const OscillatorCoefficients& coefficients) override
+    {
+        m_frequency = coefficients.frequency;
+        m_step = coefficients.step;
+        m_sinus = coefficients.sinus;
+        m_cosinus = coefficients.cosinus;
+        m_frequencyChanged = true;
+    }
+    
+    void render(float* output, std::size_t count, const OscillatorCoefficients& target, double targetAmplitude, std::size_t glideSteps) override
+    {
+        assert(glideSteps <= count && "Argument \"glideSteps\" must not exceed \"count\"!");
+        
+        const double startPhase = m_phase;
+        const double startStep = twoPI * m_frequency / sampleRate; // sampleRate might have changed since frequency() was set
+        const double startAmplitude = m_amplitude;
+        const double stepIncrement = glideSteps ? (target.step - startStep) / glideSteps : 0.0;
+        const double amplitudeIncrement = glideSteps ? (targetAmplitude - m_amplitude) / glideSteps : 0.0;
+        
+        // Sample i is played before the phase advances by the step of glide step i + 1, so its phase is
+        // the sum of the steps 1 ... i: i * startStep + stepIncrement * i * (i + 1) / 2
+        for (std::size_t i = 0; i < glideSteps; i++)
+        {
+            const double n = static_cast<int>(i);
+            const double phase = startPhase + n * startStep + stepIncrement * n * (n + 1.0) / 2.0;
+            
+            output[i] = static_cast<float>((startAmplitude + (n + 1.0) * amplitudeIncrement) * sine(wrap(phase)));
+        }
+        
+        m_phase = glideEndPhase(startPhase, startStep, stepIncrement, glideSteps);
+        frequency(target);
+        m_amplitude = targetAmplitude;
+        
+        // the rest of the block has a constant frequency, rotate from the phase where the glide ended
+        m_x = sine(m_phase);
+        m_y = sine(wrap(m_phase + PI / 2.0));
+        for (std::size_t i = glideSteps; i < count; i++)
+        {
+            double oldX = m_x;
+            m_x = m_x * m_cosinus + m_y * m_sinus;
+            m_y = oldX * -m_sinus + m_y * m_cosinus;
+            
+            output[i] = static_cast<float>(m_amplitude * oldX);
+        }
+        
+        endFrame(count, glideSteps);
+    }
+    
+    // the phase after render() only depends on the phase, frequency and glide, no sample has to be computed
+    void advance(std::size_t count, const OscillatorCoefficients& target, double targetAmplitude, std::size_t glideSteps) override
+    {
+        const double startStep = twoPI * m_frequency / sampleRate;
+        const double stepIncrement = glideSteps ? (target.step - startStep) / glideSteps : 0.0;
+        
+        m_phase = glideEndPhase(m_phase, startStep, stepIncrement, glideSteps);
+        frequency(target);
+        m_amplitude = targetAmplitude;
+        
+        // the rotation isn't advanced, render() restarts it from the phase anyway
+        endFrame(count, glideSteps);
     }
     
     using ToneGenerator::frequency;
@@ -65,10 +177,62 @@ public:
 
 
 private:
+    // maps a phase >= -PI to [-PI, PI), the frequencies are never negative so that is all we need.
+    // The truncating int cast vectorizes where std::floor doesn't
+    double wrap(double phase) const
+    {
+        return phase - twoPI * static_cast<int>(phase / twoPI + 0.5);
+    }
+    
+    // the phase after the glide of render() started at startPhase
+    double glideEndPhase(double startPhase, double startStep, double stepIncrement, std::size_t glideSteps) const
+    {
+        const double glide = static_cast<double>(glideSteps);
+        return wrap(startPhase + glide * startStep + stepIncrement * glide * (glide + 1.0) / 2.0);
+    }
+    
+    // moves the phase over the constant part of a rendered block
+    void endFrame(std::size_t count, std::size_t glideSteps)
+    {
+        m_phase = wrap(m_phase + (count - glideSteps) * m_step);
+        m_frequencyChanged = false;
+        m_accumulating = false;
+        m_samplesSinceSync = count - glideSteps;
+    }
+    
+    void advancePhase()
+    {
+        m_phase += m_step;
+        if (m_phase >= PI)
+            m_phase -= twoPI;
+    }
+    
+    // sine for phases in [-PI, PI], folded into [0, PI / 2] and evaluated with
+    // a Taylor polynomial up to x^11 (error < 1e-7). There are no branches, so loops calling
+    // this can be vectorized
+    double sine(double phase) const
+    {
+        const double magnitude = std::fabs(phase);
+        const double mirrored = PI - magnitude;
+        const double x = magnitude < mirrored ? magnitude : mirrored;
+        
+        const double x2 = x * x;
+        return std::copysign(x, phase) * (1.0 + x2 * (-1.0 / 6.0 + x2 * (1.0 / 120.0 + x2 * (-1.0 / 5040.0
+                                        + x2 * (1.0 / 362880.0 + x2 * (-1.0 / 39916800.0))))));
+    }
+    
+    // number of rotated samples after which the rotation is restarted from the phase
+    static const std::size_t renormalisationInterval = 4096;
+    
     double m_sinus;
     double m_cosinus;
+    double m_step;
     double m_x;
     double m_y;
+    double m_phase;
+    bool m_frequencyChanged;
+    bool m_accumulating;
+    std::size_t m_samplesSinceSync;
     
     const double PI = std::atan(1.0) * 4.0;
     const double twoPI = 2.0 * PI;
@@ -0,0 +1,432 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "SocketServer.hpp"
+#include "PCM.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+
+namespace
+{
+    const char          magic[4] = { 'S', 'W', 'S', '1' };
+    const std::size_t   requestHeaderSize = 12;
+    const std::uint16_t formatInt16 = PCM::formatInteger;
+    const std::uint16_t formatFloat = PCM::formatFloat;
+
+    // every connection allocates a synthesis per channel, so a header can't ask for arbitrary amounts
+    const std::size_t   maxChannels = 32;
+    const std::size_t   minSampleRate = 8000;
+    const std::size_t   maxSampleRate = 384000;
+
+    // at most this much is read from one connection per event, so one sender can't starve the others
+    const std::size_t   receiveChunkSize = 64 * 1024;
+
+    // a connection isn't read from while this much output waits for the client
+    const std::size_t   maxPendingOutput = 1024 * 1024;
+
+    const std::size_t   maxEvents = 64;
+
+    std::uint32_t readLittleEndian(const unsigned char* bytes, std::size_t numberOfBytes)
+    {
+        std::uint32_t value = 0;
+        for (std::size_t i = 0; i < numberOfBytes; ++i)
+            value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+        return value;
+    }
+
+    void appendLittleEndian(std::vector<unsigned char>& bytes, std::uint32_t value, std::size_t numberOfBytes)
+    {
+        for (std::size_t i = 0; i < numberOfBytes; ++i)
+            bytes.push_back(static_cast<unsigned char>((value >> (8 * i)) & 0xFF));
+    }
+
+    std::size_t bytesPerSample(std::uint16_t format)
+    {
+        return format == formatInt16 ? 2 : 4;
+    }
+
+    void setNonBlocking(int socket)
+    {
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+    }
+}
+
+
+/**
+ * \param FFTSize         The analysis size of every connection
+ * \param hopSize         The distance between two frames of every connection
+ * \param numberOfThreads The size of the worker pool including the event loop thread, 0 uses every core
+ */
+SocketServer::SocketServer(std::size_t FFTSize, std::size_t hopSize, std::size_t numberOfThreads) :
+    m_FFTSize(FFTSize),
+    m_hopSize(hopSize),
+    m_epoll(epoll_create1(EPOLL_CLOEXEC)),
+    m_stopEvent(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+    m_workerPool(numberOfThreads)
+{
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = m_stopEvent;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_stopEvent, &event);
+}
+
+
+SocketServer::~SocketServer()
+{
+    while (!m_connections.empty())
+        close(m_connections.begin()->first);
+
+    for (int listener: m_listeners)
+        ::close(listener);
+    if (!m_unixPath.empty())
+        unlink(m_unixPath.c_str());
+
+    ::close(m_stopEvent);
+    ::close(m_epoll);
+}
+
+
+/**
+ * \brief Accepts connections on a Unix domain socket, an existing file at path is replaced.
+ */
+bool SocketServer::listenUnix(const std::string& path)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "The socket path \"" << path << "\" is too long." << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+    {
+        std::cerr << "Could not create a socket for \"" << path << "\": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        std::cerr << "Could not bind \"" << path << "\": " << std::strerror(errno) << std::endl;
+        ::close(listener);
+        return false;
+    }
+
+    m_unixPath = path;
+    return addListener(listener);
+}
+
+
+/**
+ * \brief Accepts connections on a TCP port of the loopback interface, other hosts can't connect.
+ */
+bool SocketServer::listenTCP(std::uint16_t port)
+{
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+    {
+        std::cerr << "Could not create a socket for port " << port << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    const int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        std::cerr << "Could not bind port " << port << ": " << std::strerror(errno) << std::endl;
+        ::close(listener);
+        return false;
+    }
+
+    return addListener(listener);
+}
+
+
+/**
+ * \brief Serves all connections until stop() is called.
+ */
+void SocketServer::run()
+{
+    epoll_event events[maxEvents];
+    std::vector<Connection*> active;
+
+    while (true)
+    {
+        const int numberOfEvents = epoll_wait(m_epoll, events, maxEvents, -1);
+        if (numberOfEvents < 0 && errno != EINTR)
+        {
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+
+        active.clear();
+        for (int i = 0; i < numberOfEvents; ++i)
+        {
+            const int socket = events[i].data.fd;
+
+            if (socket == m_stopEvent)
+                return;
+
+            if (std::find(m_listeners.begin(), m_listeners.end(), socket) != m_listeners.end())
+            {
+                accept(socket);
+                continue;
+            }
+
+            Connection& connection = *m_connections[socket];
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                receive(connection);
+            active.push_back(&connection);
+        }
+
+        // the synthesis of every connection is independent, so they run in parallel
+        m_workerPool.run(active.size(), [this, &active](std::size_t i)
+                         {
+                             process(*active[i]);
+                         });
+
+        for (Connection* connection: active)
+        {
+            if (!connection->error.empty())
+            {
+                std::cerr << "Closing connection: " << connection->error << std::endl;
+                close(connection->socket);
+                continue;
+            }
+
+            send(*connection);
+
+            if (!connection->error.empty() || (connection->flushed && connection->output.empty()))
+                close(connection->socket);
+            else
+                updateEvents(*connection);
+        }
+    }
+}
+
+
+/**
+ * \brief Makes run() return. Only writes to an eventfd, so it can be called from a signal handler.
+ */
+void SocketServer::stop()
+{
+    const std::uint64_t one = 1;
+    ssize_t written = write(m_stopEvent, &one, sizeof(one));
+    (void)written;
+}
+
+
+bool SocketServer::addListener(int listener)
+{
+    if (::listen(listener, SOMAXCONN) != 0)
+    {
+        std::cerr << "Could not listen: " << std::strerror(errno) << std::endl;
+        ::close(listener);
+        return false;
+    }
+    setNonBlocking(listener);
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, listener, &event);
+
+    m_listeners.push_back(listener);
+    return true;
+}
+
+
+void SocketServer::accept(int listener)
+{
+    int socket;
+    while ((socket = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+    {
+        auto connection = std::make_unique<Connection>();
+        connection->socket = socket;
+        connection->headerReceived = false;
+        connection->endOfInput = false;
+        connection->flushed = false;
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = socket;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event);
+
+        m_connections[socket] = std::move(connection);
+    }
+}
+
+
+void SocketServer::receive(Connection& connection)
+{
+    if (connection.endOfInput)
+        return;
+
+    const std::size_t size = connection.input.size();
+    connection.input.resize(size + receiveChunkSize);
+
+    const ssize_t received = recv(connection.socket, connection.input.data() + size, receiveChunkSize, 0);
+    connection.input.resize(size + std::max<ssize_t>(received, 0));
+
+    if (received == 0)
+        connection.endOfInput = true;
+    else if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        connection.error = std::strerror(errno);
+}
+
+
+/**
+ * \brief Synthesizes all complete sample frames the connection received. Only touches
+ *        the connection, so different connections can be processed on different threads.
+ */
+void SocketServer::process(Connection& connection)
+{
+    if (!connection.error.empty() || connection.flushed)
+        return;
+
+    if (!connection.headerReceived)
+    {
+        if (connection.input.size() < requestHeaderSize)
+        {
+            if (connection.endOfInput)
+                connection.error = "the input ended before the header";
+            return;
+        }
+
+        const unsigned char* header = connection.input.data();
+        connection.sampleRate = readLittleEndian(header + 4, 4);
+        connection.numberOfChannels = readLittleEndian(header + 8, 2);
+        connection.format = readLittleEndian(header + 10, 2);
+
+        if (std::memcmp(header, magic, 4) != 0 || connection.sampleRate == 0 || connection.numberOfChannels == 0
+            || (connection.format != formatInt16 && connection.format != formatFloat))
+        {
+            connection.error = "malformed header";
+            return;
+        }
+        if (connection.numberOfChannels > maxChannels)
+        {
+            connection.error = "more than " + std::to_string(maxChannels) + " channels";
+            return;
+        }
+        if (connection.sampleRate < minSampleRate || connection.sampleRate > maxSampleRate)
+        {
+            connection.error = "sample rate outside of " + std::to_string(minSampleRate) + " to " + std::to_string(maxSampleRate) + " Hz";
+            return;
+        }
+
+        connection.sineWaveSpeech = std::make_unique<MultichannelSineWaveSpeech>(connection.numberOfChannels, m_FFTSize, m_hopSize, 50, false);
+        connection.sineWaveSpeech->sampleRate(connection.sampleRate);
+
+        connection.output.insert(connection.output.end(), magic, magic + 4);
+        appendLittleEndian(connection.output, connection.sampleRate, 4);
+        appendLittleEndian(connection.output, connection.numberOfChannels, 2);
+        appendLittleEndian(connection.output, connection.format, 2);
+        appendLittleEndian(connection.output, static_cast<std::uint32_t>(connection.sineWaveSpeech->latency()), 4);
+
+        connection.input.erase(connection.input.begin(), connection.input.begin() + requestHeaderSize);
+        connection.headerReceived = true;
+    }
+
+    const std::size_t sampleSize = bytesPerSample(connection.format);
+    const std::size_t frameSize = sampleSize * connection.numberOfChannels;
+    std::size_t numberOfFrames = connection.input.size() / frameSize;
+
+    // decode the complete frames, at the end add silence to push the last samples through
+    std::size_t flushFrames = 0;
+    if (connection.endOfInput)
+        flushFrames = connection.sineWaveSpeech->latency();
+
+    connection.samples.resize((numberOfFrames + flushFrames) * connection.numberOfChannels);
+    PCM::decode(connection.input.data(), connection.format, sampleSize, connection.samples.data(), numberOfFrames * connection.numberOfChannels);
+    std::fill(connection.samples.begin() + numberOfFrames * connection.numberOfChannels, connection.samples.end(), 0.f);
+
+    connection.input.erase(connection.input.begin(), connection.input.begin() + numberOfFrames * frameSize);
+    numberOfFrames += flushFrames;
+
+    connection.sineWaveSpeech->processInterleaved(connection.samples.data(), connection.samples.data(), numberOfFrames);
+
+    const std::size_t outputPosition = connection.output.size();
+    connection.output.resize(outputPosition + connection.samples.size() * sampleSize);
+    if (connection.format == formatInt16)
+        PCM::encodeInt16(connection.samples.data(), connection.output.data() + outputPosition, connection.samples.size());
+    else
+        PCM::encodeFloat(connection.samples.data(), connection.output.data() + outputPosition, connection.samples.size());
+
+    if (connection.endOfInput)
+        connection.flushed = true;
+}
+
+
+void SocketServer::send(Connection& connection)
+{
+    if (connection.output.empty())
+        return;
+
+    const ssize_t sent = ::send(connection.socket, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+    if (sent > 0)
+        connection.output.erase(connection.output.begin(), connection.output.begin() + sent);
+    else if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        connection.error = std::strerror(errno);
+}
+
+
+/**
+ * \brief Waits for the client to take its output before reading more input from it.
+ */
+void SocketServer::updateEvents(Connection& connection)
+{
+    epoll_event event = {};
+    event.data.fd = connection.socket;
+    if (!connection.endOfInput && connection.output.size() < maxPendingOutput)
+        event.events |= EPOLLIN | EPOLLRDHUP;
+    if (!connection.output.empty())
+        event.events |= EPOLLOUT;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection.socket, &event);
+}
+
+
+void SocketServer::close(int socket)
+{
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, nullptr);
+    ::close(socket);
+    m_connections.erase(socket);
+}
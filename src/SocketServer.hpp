@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef SOCKETSERVER_HPP
+#define SOCKETSERVER_HPP
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include "MultichannelSineWaveSpeech.hpp"
+#include "WorkerPool.hpp"
+
+/*
+ * \brief Serves sine wave speech over a Unix domain socket or a localhost TCP port.
+ *        One epoll loop handles all connections, the synthesis of every connection that
+ *        received samples runs in parallel on a worker pool.
+ *
+ * The protocol, all numbers little endian:
+ *   client -> server: "SWS1", uint32 sample rate, uint16 channels, uint16 format,
+ *                     then interleaved samples until the client shuts down its sending side
+ *   server -> client: "SWS1", uint32 sample rate, uint16 channels, uint16 format, uint32 latency,
+ *                     then the sine wave speech in the same format, latency samples later
+ * The format is 1 for 16 bit integer and 3 for 32 bit float samples, as in WAV files.
+ * After the input ends, latency more samples are sent so the output is complete, then the
+ * server closes the connection. A malformed header, more than 32 channels or a sample rate
+ * outside of 8 kHz to 384 kHz close the connection right away.
+ */
+
+class SocketServer
+{
+public:
+    SocketServer(std::size_t FFTSize, std::size_t hopSize, std::size_t numberOfThreads = 0);
+    ~SocketServer();
+
+    bool listenUnix(const std::string& path);
+    bool listenTCP(std::uint16_t port);
+
+    void run();
+    void stop();
+
+
+private:
+    struct Connection
+    {
+        int                                          socket;
+        std::vector<unsigned char>                   input;          // received, not processed yet
+        std::vector<unsigned char>                   output;         // processed, not sent yet
+        bool                                         headerReceived;
+        std::uint32_t                                sampleRate;
+        std::uint16_t                                numberOfChannels;
+        std::uint16_t                                format;
+        std::unique_ptr<MultichannelSineWaveSpeech>  sineWaveSpeech;
+        std::vector<float>                           samples;
+        bool                                         endOfInput;
+        bool                                         flushed;
+        std::string                                  error;
+    };
+
+    bool addListener(int socket);
+    void accept(int listener);
+    void receive(Connection& connection);
+    void process(Connection& connection);
+    void send(Connection& connection);
+    void updateEvents(Connection& connection);
+    void close(int socket);
+
+    std::size_t                                  m_FFTSize;
+    std::size_t                                  m_hopSize;
+    int                                          m_epoll;
+    int                                          m_stopEvent;
+    std::vector<int>                             m_listeners;
+    std::string                                  m_unixPath;
+    std::map<int, std::unique_ptr<Connection>>   m_connections;
+    WorkerPool                                   m_workerPool;
+};
+
+
+#endif // SOCKETSERVER_HPP
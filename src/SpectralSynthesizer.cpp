@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "SpectralSynthesizer.hpp"
+
+#include "simple_fft/fft.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+    const double PI = std::atan(1.0) * 4.0;
+
+    // number of bins on each side of the partial that are written into the spectrum.
+    // the Hann main lobe is 2 bins wide, the rest are the strongest side lobes
+    const int lobeWidth = 4;
+
+    // resolution of the kernel table in entries per bin
+    const int kernelOversampling = 64;
+}
+
+
+SpectralSynthesizer::SpectralSynthesizer(std::size_t FFTSize, std::size_t hopSize, std::size_t numberOfPartials) :
+    m_FFTSize(FFTSize),
+    m_hopSize(hopSize),
+    m_phases(numberOfPartials, 0.0),
+    m_lastFrequencies(numberOfPartials, 0.f)
+{
+    assert((FFTSize && !(FFTSize & (FFTSize - 1))) && "Argument \"FFTSize\" has to be a power of 2!");
+    assert(hopSize > 0 && hopSize <= FFTSize / 2 && "Argument \"hopSize\" has to be in [1, FFTSize / 2]!");
+
+    m_tables = tables(FFTSize, hopSize);
+}
+
+
+/**
+ * \brief Renders one frame of partials and overlap-adds it into the output.
+ *
+ * \param partials   The partials of this frame, a partial keeps its index from frame to frame
+ * \param sampleRate The sample rate of the output
+ * \param spectrum   FFTSize values of scratch memory, any synthesizer of this size that doesn't run at the same time can use the same
+ * \param output     The start of the frame in the output, FFTSize samples are added
+ *
+ * Only allocates memory if there are more partials than the synthesizer was created or reset for.
+ */
+void SpectralSynthesizer::synthesizeFrame(const std::vector<Partial>& partials, std::size_t sampleRate, std::vector<std::complex<float>>& spectrum, float* output)
+{
+    assert(spectrum.size() == m_FFTSize && "Argument \"spectrum\" has to have FFTSize values!");
+
+    std::fill(spectrum.begin(), spectrum.end(), std::complex<float>(0.f, 0.f));
+
+    advance(partials, sampleRate);
+
+    const int size = static_cast<int>(m_FFTSize);
+
+    for (std::size_t j = 0; j < partials.size(); j++)
+    {
+        const Partial& partial = partials[j];
+
+        if (partial.amplitude <= 0.f)
+            continue;
+
+        const float bin = partial.frequency * m_FFTSize / sampleRate;
+        const std::complex<float> phasor = std::polar(partial.amplitude / 2.f, static_cast<float>(m_phases[j]));
+
+        // the negative frequency half is the complex conjugate, which keeps the frame real
+        const int firstBin = static_cast<int>(std::floor(bin)) - lobeWidth + 1;
+        for (int k = firstBin; k < firstBin + 2 * lobeWidth; k++)
+        {
+            // (-1)^k moves the time origin from the frame center to its start
+            const float sign = (k & 1) ? -1.f : 1.f;
+            const std::complex<float> value = phasor * (sign * kernel(k - bin));
+
+            const int index = ((k % size) + size) % size;
+            spectrum[index] += value;
+            spectrum[(size - index) % size] += std::conj(value);
+        }
+    }
+
+    const char* error = nullptr;
+    if( !simple_fft::IFFT(spectrum, m_FFTSize, error) )
+        std::cout << error << std::endl;
+
+    for (std::size_t n = 0; n < m_FFTSize; n++)
+    {
+        output[n] += spectrum[n].real() * m_tables->normalisation[n % m_hopSize];
+    }
+}
+
+
+/**
+ * \brief Moves the phases of the partials to this frame without rendering it, synthesizeFrame()
+ *        continues from the same state as if the frame was synthesized.
+ */
+void SpectralSynthesizer::advance(const std::vector<Partial>& partials, std::size_t sampleRate)
+{
+    if (m_phases.size() < partials.size())
+    {
+        m_phases.resize(partials.size(), 0.0);
+        m_lastFrequencies.resize(partials.size(), 0.f);
+    }
+
+    for (std::size_t j = 0; j < partials.size(); j++)
+    {
+        // advance the phase from the last frame center to this one with the mean frequency
+        m_phases[j] += PI * (m_lastFrequencies[j] + partials[j].frequency) * m_hopSize / sampleRate;
+        m_phases[j] = std::fmod(m_phases[j], 2.0 * PI);
+        m_lastFrequencies[j] = partials[j].frequency;
+    }
+}
+
+
+/**
+ * \brief Forgets the phases of all partials, e.g. before starting a new signal.
+ *
+ * \param numberOfPartials The number of partials the next frames will have
+ */
+void SpectralSynthesizer::reset(std::size_t numberOfPartials)
+{
+    m_phases.assign(numberOfPartials, 0.0);
+    m_lastFrequencies.assign(numberOfPartials, 0.f);
+}
+
+
+/**
+ * \brief Returns the shared tables for the given sizes, computing them if no one holds them yet.
+ */
+std::shared_ptr<const SpectralSynthesizer::Tables> SpectralSynthesizer::tables(std::size_t FFTSize, std::size_t hopSize)
+{
+    static std::mutex                                                                  tablesMutex;
+    static std::map<std::pair<std::size_t, std::size_t>, std::weak_ptr<const Tables>>  cache;
+
+    std::lock_guard<std::mutex> lock(tablesMutex);
+
+    auto& cached = cache[std::make_pair(FFTSize, hopSize)];
+    auto shared = cached.lock();
+    if (shared)
+        return shared;
+
+    auto tables = std::make_shared<Tables>();
+    tables->kernel.resize(2 * (lobeWidth + 1) * kernelOversampling + 1);
+    tables->normalisation.resize(hopSize, 0.f);
+
+    // The spectrum of the Hann window centered in the frame, sampled between the bins.
+    // Because the window is symmetric around FFTSize / 2 the spectrum is real.
+    for (std::size_t i = 0; i < tables->kernel.size(); i++)
+    {
+        const double offset = static_cast<double>(i) / kernelOversampling - (lobeWidth + 1);
+
+        double sum = 0.0;
+        for (std::size_t n = 0; n < FFTSize; n++)
+        {
+            const double window = 0.5 * (1.0 - std::cos(2.0 * PI * n / FFTSize));
+            sum += window * std::cos(2.0 * PI * offset * (static_cast<double>(n) - FFTSize / 2.0) / FFTSize);
+        }
+
+        tables->kernel[i] = static_cast<float>(sum);
+    }
+
+    // The overlapping windows only sum up to a constant if hopSize divides FFTSize.
+    // For any other hop the sum is periodic with hopSize, so divide by it per sample.
+    for (std::size_t n = 0; n < FFTSize; n++)
+    {
+        tables->normalisation[n % hopSize] += 0.5f * (1.f - std::cos(2.f * PI * n / FFTSize));
+    }
+    for (auto& sum: tables->normalisation)
+    {
+        sum = 1.f / sum;
+    }
+
+    cached = tables;
+    return tables;
+}
+
+
+float SpectralSynthesizer::kernel(float binOffset) const
+{
+    const float position = (binOffset + (lobeWidth + 1)) * kernelOversampling;
+    const std::size_t index = static_cast<std::size_t>(position);
+    const float fraction = position - index;
+    const auto& table = m_tables->kernel;
+
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
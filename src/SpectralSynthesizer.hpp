@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef SPECTRALSYNTHESIZER_HPP
+#define SPECTRALSYNTHESIZER_HPP
+
+#include <vector>
+#include <complex>
+#include <memory>
+
+/*
+ * \brief Additive synthesis through the inverse FFT (FFT^-1 synthesis).
+ *        Every partial of a frame is written into a spectrum as the main lobe of the
+ *        Hann window, shifted to the partials frequency. One inverse FFT per frame then
+ *        renders all partials at once as a windowed frame, which is overlap-added into
+ *        the output. The cost per partial is a handful of bins instead of one oscillator
+ *        per sample, so dense partial tracks are cheap.
+ *        Partials are identified by their index in the frame, their phase stays continous
+ *        from frame to frame.
+ *        The kernel and normalisation tables only depend on FFTSize and hopSize, they are
+ *        shared by all synthesizers of the same size. The spectrum of a frame is scratch memory
+ *        of the caller, so a synthesizer only keeps the phases of its partials.
+ */
+
+class SpectralSynthesizer
+{
+public:
+
+    struct Partial
+    {
+        float frequency;
+        float amplitude;
+    };
+
+
+    SpectralSynthesizer(std::size_t FFTSize, std::size_t hopSize, std::size_t numberOfPartials = 1);
+
+    void synthesizeFrame(const std::vector<Partial>& partials, std::size_t sampleRate, std::vector<std::complex<float>>& spectrum, float* output);
+    void advance(const std::vector<Partial>& partials, std::size_t sampleRate);
+    void reset(std::size_t numberOfPartials);
+
+
+private:
+    // immutable, see tables()
+    struct Tables
+    {
+        std::vector<float> kernel;
+        std::vector<float> normalisation;
+    };
+
+    static std::shared_ptr<const Tables> tables(std::size_t FFTSize, std::size_t hopSize);
+
+    float kernel(float binOffset) const;
+
+    std::size_t                      m_FFTSize;
+    std::size_t                      m_hopSize;
+    std::shared_ptr<const Tables>    m_tables;
+    std::vector<double>              m_phases;
+    std::vector<float>               m_lastFrequencies;
+};
+
+
+#endif // SPECTRALSYNTHESIZER_HPP
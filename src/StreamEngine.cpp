@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "StreamEngine.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace
+{
+    // process() splits the blocks into a few tasks per thread, so threads that finish early can steal the rest
+    const std::size_t tasksPerThread = 4;
+}
+
+
+/**
+ * \param FFTSize         The analysis size of every stream
+ * \param hopSize         The distance between two frames of every stream
+ * \param sampleRate      The sample rate of every stream
+ * \param numberOfThreads The size of the worker pool including the caller of process(), 0 uses every core
+ */
+StreamEngine::StreamEngine(std::size_t FFTSize, std::size_t hopSize, std::size_t sampleRate, std::size_t numberOfThreads) :
+    m_FFTSize(FFTSize),
+    m_hopSize(hopSize),
+    m_sampleRate(sampleRate),
+    m_workerPool(numberOfThreads)
+{
+    for (std::size_t i = 0; i < tasksPerThread * m_workerPool.numberOfThreads(); ++i)
+        m_workspaces.emplace_back(FFTSize);
+}
+
+
+/**
+ * \brief Creates a new stream and returns its number. The numbers of removed streams are reused.
+ *        Don't call it while process() runs.
+ */
+std::size_t StreamEngine::addStream()
+{
+    // without a workspace of its own, process() lends it one
+    auto sineWaveSpeech = std::make_unique<SineWaveSpeech>(m_FFTSize, m_hopSize, 50, false, false);
+    sineWaveSpeech->sampleRate(m_sampleRate);
+
+    if (m_freeStreams.empty())
+    {
+        m_streams.push_back(std::move(sineWaveSpeech));
+        return m_streams.size() - 1;
+    }
+
+    const std::size_t stream = m_freeStreams.back();
+    m_freeStreams.pop_back();
+    m_streams[stream] = std::move(sineWaveSpeech);
+    return stream;
+}
+
+
+/**
+ * \brief Ends a stream and frees its state. Don't call it while process() runs.
+ */
+void StreamEngine::removeStream(std::size_t stream)
+{
+    assert(stream < m_streams.size() && m_streams[stream] && "Argument \"stream\" is not a stream!");
+
+    m_streams[stream].reset();
+    m_freeStreams.push_back(stream);
+}
+
+
+/**
+ * \brief Processes the blocks of many streams in parallel and returns when all are done.
+ *        A stream may only appear once per call, its blocks have to arrive in order.
+ *        Only one thread may call it at a time.
+ */
+void StreamEngine::process(const std::vector<Block>& blocks)
+{
+    // every task works through a contiguous share of the blocks with its own workspace
+    const std::size_t numberOfTasks = std::min(blocks.size(), m_workspaces.size());
+
+    m_workerPool.run(numberOfTasks, [this, &blocks, numberOfTasks](std::size_t task)
+                     {
+                         SineWaveSpeech::Workspace& workspace = m_workspaces[task];
+
+                         for (std::size_t i = blocks.size() * task / numberOfTasks; i < blocks.size() * (task + 1) / numberOfTasks; ++i)
+                         {
+                             const Block& block = blocks[i];
+                             m_streams[block.stream]->processBlock(block.in, block.out, block.n, workspace);
+                         }
+                     });
+}
+
+
+/**
+ * \brief The synthesis of a stream, e.g. to change its parameters.
+ */
+SineWaveSpeech& StreamEngine::stream(std::size_t stream)
+{
+    assert(stream < m_streams.size() && m_streams[stream] && "Argument \"stream\" is not a stream!");
+
+    return *m_streams[stream];
+}
+
+
+/**
+ * \brief The number of streams that currently exist.
+ */
+std::size_t StreamEngine::numberOfStreams() const
+{
+    return m_streams.size() - m_freeStreams.size();
+}
+
+
+std::size_t StreamEngine::latency() const
+{
+    return m_FFTSize;
+}
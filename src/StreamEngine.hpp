@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef STREAMENGINE_HPP
+#define STREAMENGINE_HPP
+
+#include <vector>
+#include <memory>
+
+#include "SineWaveSpeech.hpp"
+#include "WorkerPool.hpp"
+
+/*
+ * \brief Many independent mono voice streams in one process.
+ *        Every stream only owns its streaming state, the window, the synthesis kernel and
+ *        the oscillator table are shared by all streams of the same size and sample rate.
+ *        The FFT scratch memory belongs to the tasks of process(), a few per thread, so it
+ *        doesn't grow with the number of streams.
+ *        process() runs the blocks of many streams at once on a fixed pool of threads.
+ */
+
+class StreamEngine
+{
+public:
+
+    // one block of one stream, see SineWaveSpeech::processBlock()
+    struct Block
+    {
+        std::size_t  stream;
+        const float* in;
+        float*       out;
+        std::size_t  n;
+    };
+
+
+    StreamEngine(std::size_t FFTSize, std::size_t hopSize, std::size_t sampleRate, std::size_t numberOfThreads = 0);
+
+    std::size_t addStream();
+    void        removeStream(std::size_t stream);
+
+    void        process(const std::vector<Block>& blocks);
+
+    SineWaveSpeech& stream(std::size_t stream);
+    std::size_t     numberOfStreams() const;
+    std::size_t     latency() const;
+
+
+private:
+    std::size_t                                  m_FFTSize;
+    std::size_t                                  m_hopSize;
+    std::size_t                                  m_sampleRate;
+    std::vector<std::unique_ptr<SineWaveSpeech>> m_streams;      // nullptr for removed streams
+    std::vector<std::size_t>                     m_freeStreams;
+    WorkerPool                                   m_workerPool;
+    std::vector<SineWaveSpeech::Workspace>       m_workspaces;   // one per task of process()
+};
+
+
+#endif // STREAMENGINE_HPP
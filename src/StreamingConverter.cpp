@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "StreamingConverter.hpp"
+#include "MappedWav.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+/**
+ * \param chunkSize How many frames are read, processed and written at once
+ *
+ * The other arguments are the same as for SineWaveSpeech.
+ */
+StreamingConverter::StreamingConverter(std::size_t FFTSize, std::size_t hopSize, std::size_t glideSteps, std::size_t chunkSize) :
+    m_FFTSize(FFTSize),
+    m_hopSize(hopSize),
+    m_glideSteps(glideSteps),
+    m_chunkSize(chunkSize),
+    m_parameters{ 3000.f, std::sqrt(2.f), glideSteps, 0, SineWaveSpeech::Synthesis::ToneGenerator },
+    m_numberOfFrames(0),
+    m_sampleRate(0)
+{
+
+}
+
+
+/**
+ * \brief The parameters of the following conversions, see SineWaveSpeech::parameters().
+ */
+void StreamingConverter::parameters(const SineWaveSpeech::Parameters& parameters)
+{
+    m_parameters = parameters;
+}
+
+
+/**
+ * \brief Converts a WAV file to a 16 bit sine wave speech WAV file of the same length.
+ *
+ * \return Whether both files could be opened, the reason is printed if not
+ */
+bool StreamingConverter::convert(const std::string& inputPath, const std::string& outputPath)
+{
+    MappedWavReader reader;
+    if (!reader.open(inputPath))
+        return false;
+
+    m_numberOfFrames = reader.numberOfFrames();
+    m_sampleRate = reader.sampleRate();
+    const std::size_t numberOfChannels = reader.numberOfChannels();
+
+    MappedWavWriter writer;
+    if (!writer.open(outputPath, numberOfChannels, m_sampleRate, m_numberOfFrames))
+        return false;
+
+    // the synthesis is kept for files with the same number of channels
+    if (!m_sineWaveSpeech || m_sineWaveSpeech->numberOfChannels() != numberOfChannels)
+        m_sineWaveSpeech = std::make_unique<MultichannelSineWaveSpeech>(numberOfChannels, m_FFTSize, m_hopSize, m_glideSteps, false);
+
+    // 16 bit files are analysed straight from the mapping, every other format is decoded into the chunk first
+    const std::int16_t* int16Samples = reader.int16Samples();
+    m_sineWaveSpeech->int16Input(int16Samples != nullptr);
+
+    m_sineWaveSpeech->parameters(m_parameters);
+    m_sineWaveSpeech->sampleRate(m_sampleRate);
+    m_sineWaveSpeech->reset();
+    m_chunk.resize(m_chunkSize * numberOfChannels);
+    m_silence.assign(int16Samples ? m_chunkSize * numberOfChannels : 0, 0);
+
+    // after the input, latency frames of silence push the last output out
+    const std::size_t latency = m_sineWaveSpeech->latency();
+    const std::size_t end = m_numberOfFrames + latency;
+
+    for (std::size_t position = 0; position < end; position += m_chunkSize)
+    {
+        const std::size_t chunk = std::min(m_chunkSize, end - position);
+
+        const std::size_t inputFrames = position < m_numberOfFrames ? std::min(chunk, m_numberOfFrames - position) : 0;
+        if (int16Samples)
+        {
+            if (inputFrames > 0)
+                m_sineWaveSpeech->processInterleaved(int16Samples + position * numberOfChannels, m_chunk.data(), inputFrames);
+            m_sineWaveSpeech->processInterleaved(m_silence.data(), m_chunk.data() + inputFrames * numberOfChannels, chunk - inputFrames);
+            reader.release(position, inputFrames);
+        }
+        else
+        {
+            reader.readFrames(position, inputFrames, m_chunk.data());
+            reader.release(position, inputFrames);
+            std::fill(m_chunk.begin() + inputFrames * numberOfChannels, m_chunk.begin() + chunk * numberOfChannels, 0.f);
+
+            m_sineWaveSpeech->processInterleaved(m_chunk.data(), m_chunk.data(), chunk);
+        }
+
+        // the chunk is the output of [position - latency, position - latency + chunk), drop what is before the start
+        if (position + chunk <= latency)
+            continue;
+
+        const std::size_t skip = position < latency ? latency - position : 0;
+        const std::size_t outputPosition = position + skip - latency;
+        const std::size_t outputFrames = std::min(chunk - skip, m_numberOfFrames - std::min(m_numberOfFrames, outputPosition));
+
+        writer.writeFrames(outputPosition, outputFrames, m_chunk.data() + skip * numberOfChannels);
+        writer.release(outputPosition, outputFrames);
+    }
+
+    return writer.close();
+}
+
+
+/**
+ * \brief The number of frames of the last converted file.
+ */
+std::size_t StreamingConverter::numberOfFrames() const
+{
+    return m_numberOfFrames;
+}
+
+
+/**
+ * \brief The sample rate of the last converted file.
+ */
+std::size_t StreamingConverter::sampleRate() const
+{
+    return m_sampleRate;
+}
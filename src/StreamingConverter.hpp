@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef STREAMINGCONVERTER_HPP
+#define STREAMINGCONVERTER_HPP
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include "MultichannelSineWaveSpeech.hpp"
+
+/*
+ * \brief Converts a WAV file of any length in constant memory.
+ *        The input is read chunk by chunk from a MappedWavReader, streamed through the
+ *        processBlock() path and written to a MappedWavWriter right away. Only the chunk
+ *        buffers and the streaming state are allocated, whatever the duration of the file.
+ *        The output has the length of the input, the latency of the streaming is removed.
+ */
+
+class StreamingConverter
+{
+public:
+    StreamingConverter(std::size_t FFTSize, std::size_t hopSize, std::size_t glideSteps, std::size_t chunkSize = 8192);
+
+    void parameters(const SineWaveSpeech::Parameters& parameters);
+    bool convert(const std::string& inputPath, const std::string& outputPath);
+
+    std::size_t numberOfFrames() const;
+    std::size_t sampleRate() const;
+
+
+private:
+    std::size_t                                  m_FFTSize;
+    std::size_t                                  m_hopSize;
+    std::size_t                                  m_glideSteps;
+    std::size_t                                  m_chunkSize;
+    SineWaveSpeech::Parameters                   m_parameters;
+    std::unique_ptr<MultichannelSineWaveSpeech>  m_sineWaveSpeech;
+    std::vector<float>                           m_chunk;
+    std::vector<std::int16_t>                    m_silence;         // the input after a 16 bit file
+    std::size_t                                  m_numberOfFrames;
+    std::size_t                                  m_sampleRate;
+};
+
+
+#endif // STREAMINGCONVERTER_HPP
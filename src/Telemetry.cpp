@@ -0,0 +1,267 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+
+
+namespace
+{
+    const char* stageNames[Telemetry::numberOfStages] = { "analysis", "synthesis" };
+
+    // bucket 0 is below 1 us, bucket i is [2^(i-1), 2^i) us
+    std::size_t bucket(std::chrono::nanoseconds duration)
+    {
+        std::uint64_t microseconds = std::max<std::int64_t>(0, duration.count()) / 1000;
+        std::size_t bucket = 0;
+        while (microseconds > 0 && bucket < Telemetry::numberOfBuckets - 1)
+        {
+            microseconds >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+}
+
+
+Telemetry::Telemetry() :
+    m_callbacks(0),
+    m_deadlineMisses(0),
+    m_maxCallback(0)
+{
+    for (auto& count: m_histogram)
+        count = 0;
+    for (auto& max: m_maxStage)
+        max = 0;
+}
+
+
+/**
+ * \brief Records the processing time of one audio callback. Wait-free, call it from the audio thread.
+ *
+ * \param duration How long the callback took
+ * \param deadline The length of the period, a longer callback is a deadline miss
+ */
+void Telemetry::recordCallback(std::chrono::nanoseconds duration, std::chrono::nanoseconds deadline)
+{
+    m_histogram[bucket(duration)].fetch_add(1, std::memory_order_relaxed);
+    m_callbacks.fetch_add(1, std::memory_order_relaxed);
+    if (duration > deadline)
+        m_deadlineMisses.fetch_add(1, std::memory_order_relaxed);
+
+    updateMax(m_maxCallback, duration.count());
+}
+
+
+/**
+ * \brief Records the time of one stage of a frame. Lock-free, can be called from several threads.
+ */
+void Telemetry::recordStage(Stage stage, std::chrono::nanoseconds duration)
+{
+    updateMax(m_maxStage[static_cast<std::size_t>(stage)], duration.count());
+}
+
+
+/**
+ * \brief Reads all counters. They are read one by one while the audio thread keeps counting,
+ *        so they can be a callback apart from each other.
+ */
+Telemetry::Snapshot Telemetry::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.callbacks = m_callbacks.load(std::memory_order_relaxed);
+    snapshot.deadlineMisses = m_deadlineMisses.load(std::memory_order_relaxed);
+    snapshot.xruns = 0;
+    snapshot.underruns = 0;
+    for (std::size_t i = 0; i < numberOfBuckets; ++i)
+        snapshot.histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+    snapshot.maxCallback = std::chrono::nanoseconds(m_maxCallback.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < numberOfStages; ++i)
+        snapshot.maxStage[i] = std::chrono::nanoseconds(m_maxStage[i].load(std::memory_order_relaxed));
+    return snapshot;
+}
+
+
+/**
+ * \brief The exclusive upper bound of a histogram bucket, the last bucket has none.
+ */
+std::chrono::microseconds Telemetry::bucketUpperBound(std::size_t bucket)
+{
+    return std::chrono::microseconds(std::int64_t(1) << bucket);
+}
+
+
+void Telemetry::updateMax(std::atomic<std::int64_t>& max, std::int64_t value)
+{
+    std::int64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+
+/**
+ * \brief The upper bound of the bucket that contains the given fraction of all callbacks,
+ *        e.g. percentile(0.99) is an upper bound for 99% of the callback times.
+ */
+std::chrono::microseconds Telemetry::Snapshot::percentile(double fraction) const
+{
+    std::uint64_t total = 0;
+    for (auto count: histogram)
+        total += count;
+
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < numberOfBuckets; ++i)
+    {
+        sum += histogram[i];
+        if (sum > 0 && sum >= fraction * total)
+            return bucketUpperBound(i);
+    }
+    return bucketUpperBound(0);
+}
+
+
+/**
+ * \param telemetry The statistics to publish, has to outlive the publisher
+ * \param interval  The time between two log lines
+ * \param statsPath Where to write the JSON stats, empty to only log
+ * \param xruns     Returns the number of xruns of the audio backend
+ * \param underruns Returns how often a worker thread was too late
+ */
+TelemetryPublisher::TelemetryPublisher(const Telemetry& telemetry, std::chrono::milliseconds interval, std::string statsPath,
+                                       std::function<std::size_t()> xruns, std::function<std::size_t()> underruns) :
+    m_telemetry(telemetry),
+    m_interval(interval),
+    m_statsPath(std::move(statsPath)),
+    m_xruns(std::move(xruns)),
+    m_underruns(std::move(underruns)),
+    m_running(true)
+{
+    m_thread = std::thread(&TelemetryPublisher::run, this);
+}
+
+
+TelemetryPublisher::~TelemetryPublisher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wakeUp.notify_one();
+    m_thread.join();
+}
+
+
+/**
+ * \brief Logs and writes the current statistics right away, e.g. a last time before exiting.
+ */
+void TelemetryPublisher::publish()
+{
+    std::lock_guard<std::mutex> lock(m_publishMutex);
+
+    auto snapshot = m_telemetry.snapshot();
+    snapshot.xruns = m_xruns();
+    snapshot.underruns = m_underruns();
+
+    std::cout << "callbacks " << snapshot.callbacks
+              << ", deadline misses " << snapshot.deadlineMisses
+              << ", xruns " << snapshot.xruns
+              << ", underruns " << snapshot.underruns
+              << ", p50 < " << snapshot.percentile(0.5).count() << " us"
+              << ", p99 < " << snapshot.percentile(0.99).count() << " us"
+              << ", max " << snapshot.maxCallback.count() / 1000 << " us";
+    for (std::size_t i = 0; i < Telemetry::numberOfStages; ++i)
+        std::cout << ", " << stageNames[i] << " max " << snapshot.maxStage[i].count() / 1000 << " us";
+    std::cout << std::endl;
+
+    if (!m_statsPath.empty())
+        writeStatsFile(snapshot);
+}
+
+
+void TelemetryPublisher::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wakeUp.wait_for(lock, m_interval, [this] { return !m_running; }))
+    {
+        lock.unlock();
+        publish();
+        lock.lock();
+    }
+}
+
+
+void TelemetryPublisher::writeStatsFile(const Telemetry::Snapshot& snapshot) const
+{
+    // write next to the file and rename, which replaces it in one step
+    const std::string temporaryPath = m_statsPath + ".tmp";
+    {
+        std::ofstream file(temporaryPath);
+        if (!file)
+        {
+            std::cerr << "Could not write \"" << temporaryPath << "\"." << std::endl;
+            return;
+        }
+
+        file << "{\n"
+             << "  \"callbacks\": " << snapshot.callbacks << ",\n"
+             << "  \"deadline_misses\": " << snapshot.deadlineMisses << ",\n"
+             << "  \"xruns\": " << snapshot.xruns << ",\n"
+             << "  \"underruns\": " << snapshot.underruns << ",\n"
+             << "  \"max_callback_ns\": " << snapshot.maxCallback.count() << ",\n"
+             << "  \"max_stage_ns\": {";
+        for (std::size_t i = 0; i < Telemetry::numberOfStages; ++i)
+            file << (i ? ", " : " ") << "\"" << stageNames[i] << "\": " << snapshot.maxStage[i].count();
+        file << " },\n"
+             << "  \"histogram_us\": [";
+        for (std::size_t i = 0; i < Telemetry::numberOfBuckets; ++i)
+        {
+            // the last bucket is open ended
+            file << (i ? ",\n" : "\n") << "    { \"below\": ";
+            if (i + 1 < Telemetry::numberOfBuckets)
+                file << Telemetry::bucketUpperBound(i).count();
+            else
+                file << "null";
+            file << ", \"count\": " << snapshot.histogram[i] << " }";
+        }
+        file << "\n  ]\n"
+             << "}\n";
+
+        file.close();
+        if (!file)
+        {
+            std::cerr << "Could not write \"" << temporaryPath << "\"." << std::endl;
+            std::remove(temporaryPath.c_str());
+            return;
+        }
+    }
+
+    // a failed rename leaves the old stats in place, the temporary file is not left behind
+    if (std::rename(temporaryPath.c_str(), m_statsPath.c_str()) != 0)
+    {
+        std::cerr << "Could not replace \"" << m_statsPath << "\": " << std::strerror(errno) << std::endl;
+        std::remove(temporaryPath.c_str());
+    }
+}
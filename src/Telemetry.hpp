@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*
+ * \brief Timing statistics of the live engine.
+ *        The audio thread and the workers only update atomic counters, so recording never
+ *        blocks or allocates. Any other thread can take a snapshot() at any time.
+ *        Callback times go into a histogram with power of 2 buckets in microseconds.
+ */
+
+class Telemetry
+{
+public:
+
+    // the parts of a frame that are timed separately
+    enum class Stage
+    {
+        Analysis,
+        Synthesis
+    };
+
+    static const std::size_t numberOfStages = 2;
+    static const std::size_t numberOfBuckets = 24;     // the last bucket collects everything above 4 s
+
+    struct Snapshot
+    {
+        std::uint64_t                                         callbacks;
+        std::uint64_t                                         deadlineMisses;
+        std::uint64_t                                         xruns;            // filled in by the publisher
+        std::uint64_t                                         underruns;        // filled in by the publisher
+        std::array<std::uint64_t, numberOfBuckets>            histogram;
+        std::chrono::nanoseconds                              maxCallback;
+        std::array<std::chrono::nanoseconds, numberOfStages>  maxStage;
+
+        std::chrono::microseconds percentile(double fraction) const;
+    };
+
+
+    Telemetry();
+
+    void recordCallback(std::chrono::nanoseconds duration, std::chrono::nanoseconds deadline);
+    void recordStage(Stage stage, std::chrono::nanoseconds duration);
+
+    Snapshot snapshot() const;
+
+    static std::chrono::microseconds bucketUpperBound(std::size_t bucket);
+
+
+private:
+    static void updateMax(std::atomic<std::int64_t>& max, std::int64_t value);
+
+    std::array<std::atomic<std::uint64_t>, numberOfBuckets>  m_histogram;
+    std::atomic<std::uint64_t>                               m_callbacks;
+    std::atomic<std::uint64_t>                               m_deadlineMisses;
+    std::atomic<std::int64_t>                                m_maxCallback;
+    std::array<std::atomic<std::int64_t>, numberOfStages>    m_maxStage;
+};
+
+
+/*
+ * \brief Publishes the Telemetry of the live engine from its own, non real-time thread.
+ *        Every interval it prints a log line and rewrites a JSON stats file. The file is
+ *        replaced atomically, so readers never see a half written one.
+ */
+
+class TelemetryPublisher
+{
+public:
+    TelemetryPublisher(const Telemetry& telemetry, std::chrono::milliseconds interval, std::string statsPath,
+                       std::function<std::size_t()> xruns, std::function<std::size_t()> underruns);
+    ~TelemetryPublisher();
+
+    void publish();
+
+
+private:
+    void run();
+    void writeStatsFile(const Telemetry::Snapshot& snapshot) const;
+
+    const Telemetry&              m_telemetry;
+    std::chrono::milliseconds     m_interval;
+    std::string                   m_statsPath;
+    std::function<std::size_t()>  m_xruns;
+    std::function<std::size_t()>  m_underruns;
+    std::mutex                    m_publishMutex;
+    std::mutex                    m_mutex;
+    std::condition_variable       m_wakeUp;
+    bool                          m_running;
+    std::thread                   m_thread;
+};
+
+
+#endif // TELEMETRY_HPP
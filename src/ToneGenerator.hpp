@@ -22,6 +22,10 @@
 #define TONEGENRATOR_INCLUDE
 
 #include <cmath>
+#include <cstddef>
+#include <memory>
+
+#include "OscillatorTable.hpp"
 
 /*
  * \brief ToneGenerator base class
@@ -38,13 +42,87 @@ public:
 
     }
     
+    virtual ~ToneGenerator() = default;
+    
     virtual double getNextSample() = 0;
     
+    // a copy with the same state, e.g. to continue a signal on another thread
+    virtual std::unique_ptr<ToneGenerator> clone() const = 0;
+    
+    /**
+     * \brief Renders count samples. During the first glideSteps samples frequency and amplitude
+     *        move linearly to the target, then they stay there. glideSteps must not exceed count.
+     *        Generators that can render the glide more efficiently than sample by sample override this.
+     */
+    virtual void render(float* output, std::size_t count, const OscillatorCoefficients& target, double targetAmplitude, std::size_t glideSteps)
+    {
+        const double frequencyStep = glideSteps ? (target.frequency - m_frequency) / glideSteps : 0.0;
+        const double amplitudeStep = glideSteps ? (targetAmplitude - m_amplitude) / glideSteps : 0.0;
+        
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (i < glideSteps)
+            {
+                frequency(m_frequency + frequencyStep);
+                amplitude(m_amplitude + amplitudeStep);
+            }
+            else if (i == glideSteps)
+            {
+                frequency(target);
+                amplitude(targetAmplitude);
+            }
+            
+            output[i] = getNextSample();
+        }
+    }
+    
+    /**
+     * \brief Moves the generator to the state render() would leave it in, without the samples.
+     *        Generators that know their state after count samples in closed form override this.
+     */
+    virtual void advance(std::size_t count, const OscillatorCoefficients& target, double targetAmplitude, std::size_t glideSteps)
+    {
+        const double frequencyStep = glideSteps ? (target.frequency - m_frequency) / glideSteps : 0.0;
+        const double amplitudeStep = glideSteps ? (targetAmplitude - m_amplitude) / glideSteps : 0.0;
+        
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (i < glideSteps)
+            {
+                frequency(m_frequency + frequencyStep);
+                amplitude(m_amplitude + amplitudeStep);
+            }
+            else if (i == glideSteps)
+            {
+                frequency(target);
+                amplitude(targetAmplitude);
+            }
+            
+            getNextSample();
+        }
+    }
+    
+    /**
+     * \brief Puts the generator back into the state of a new one with the given frequency and amplitude.
+     *        Generators with a phase override this to restart it and call this one.
+     */
+    virtual void reset(double frequency, double amplitude)
+    {
+        m_amplitude = amplitude;
+        this->frequency(frequency);
+    }
+    
     virtual void frequency(double frequency)
     {
         m_frequency = frequency;
     }
     
+    // set the frequency from precomputed coefficients, generators that can use them override this
+    virtual void frequency(const OscillatorCoefficients& coefficients)
+    {
+        frequency(coefficients.frequency);
+    }
+    
     double frequency()
     {
         return m_frequency;
@@ -64,6 +142,16 @@ public:
     double sampleRate;
     
 protected:
+    // the sum of the frequencies the count samples of render() are played with, divided by the
+    // sample rate that is how many periods the phase moves over them
+    double frequencySum(std::size_t count, double targetFrequency, std::size_t glideSteps) const
+    {
+        const double glide = static_cast<double>(glideSteps);
+        const double frequencyStep = glideSteps ? (targetFrequency - m_frequency) / glideSteps : 0.0;
+        
+        return glide * m_frequency + frequencyStep * glide * (glide + 1.0) / 2.0 + (count - glideSteps) * targetFrequency;
+    }
+    
     double m_amplitude;
     double m_frequency;
     
@@ -54,17 +54,60 @@ public:
         return m_amplitude * sample;
     }
 
+    std::unique_ptr<ToneGenerator> clone() const override
+    {
+        return std::make_unique<Triangle>(*this);
+    }
+
+    void reset(double frequency, double amplitude) override
+    {
+        m_nextSample = 0.0;
+        m_sign = 1;
+
+        ToneGenerator::reset(frequency, amplitude);
+    }
+
     void frequency(double frequency) override
     {
         m_frequency = frequency;
         m_step = 4.0 * m_frequency / sampleRate;
     }
+
+    // renders sample by sample, but ends in the state of advance(), so a shard that advanced over
+    // the frames before it continues exactly where rendering all of them would
+    void render(float* output, std::size_t count, const OscillatorCoefficients& target, double targetAmplitude, std::size_t glideSteps) override
+    {
+        const double position = advancedPosition(count, target, glideSteps);
+        ToneGenerator::render(output, count, target, targetAmplitude, glideSteps);
+        endFrame(position, target, targetAmplitude);
+    }
+
+    // the wave is linear in the phase, so its end is known without rendering it
+    void advance(std::size_t count, const OscillatorCoefficients& target, double targetAmplitude, std::size_t glideSteps) override
+    {
+        endFrame(advancedPosition(count, target, glideSteps), target, targetAmplitude);
+    }
     
     using ToneGenerator::frequency;
     using ToneGenerator::amplitude;
 
 
 private:
+    // the position in a period of 4, the rise from -1 to 1 is [0, 2], the fall back (2, 4)
+    double advancedPosition(std::size_t count, const OscillatorCoefficients& target, std::size_t glideSteps) const
+    {
+        const double position = m_sign > 0 ? m_nextSample + 1.0 : 3.0 - m_nextSample;
+        return std::fmod(position + 4.0 * frequencySum(count, target.frequency, glideSteps) / sampleRate, 4.0);
+    }
+
+    void endFrame(double position, const OscillatorCoefficients& target, double targetAmplitude)
+    {
+        m_nextSample = position <= 2.0 ? position - 1.0 : 3.0 - position;
+        m_sign = position <= 2.0 ? 1 : -1;
+        frequency(target);
+        m_amplitude = targetAmplitude;
+    }
+
     double m_nextSample;
     signed char m_sign;
     double m_step;
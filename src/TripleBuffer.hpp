@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef TRIPLEBUFFER_INCLUDE
+#define TRIPLEBUFFER_INCLUDE
+
+#include <atomic>
+
+/*
+ * \brief Hands the latest value of a T from one writer thread to one reader thread.
+ *        The writer fills a back buffer and swaps it with the middle one, the reader swaps
+ *        its front buffer with the middle one if that holds something new. Both sides are
+ *        wait-free and the reader always sees a complete value, never a half written one.
+ */
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer(const T& initial) :
+        m_buffers{ initial, initial, initial },
+        m_back(0),
+        m_middle(1),
+        m_front(2)
+    {
+
+    }
+
+    // publishes a new value. Only call from the writer thread
+    void write(const T& value)
+    {
+        m_buffers[m_back] = value;
+        m_back = m_middle.exchange(m_back | newData, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // gets the latest value if there is a new one since the last read. Only call from the reader thread
+    bool read(T& value)
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & newData))
+            return false;
+
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & indexMask;
+        value = m_buffers[m_front];
+        return true;
+    }
+
+
+private:
+    static const unsigned int indexMask = 3;
+    static const unsigned int newData = 4;
+
+    T                          m_buffers[3];
+    unsigned int               m_back;     // only touched by the writer
+    std::atomic<unsigned int>  m_middle;   // index and newData flag
+    unsigned int               m_front;    // only touched by the reader
+};
+
+#endif // TRIPLEBUFFER_INCLUDE
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "WavFile.hpp"
+#include "MappedWav.hpp"
+
+#include <utility>
+
+
+WavFile::WavFile() :
+    m_numberOfChannels(0),
+    m_sampleRate(0)
+{
+
+}
+
+
+/**
+ * \param samples          Interleaved samples in the range [-1, 1]
+ * \param numberOfChannels The number of interleaved channels
+ * \param sampleRate       The sample rate of the samples
+ */
+WavFile::WavFile(std::vector<float> samples, std::size_t numberOfChannels, std::size_t sampleRate) :
+    m_samples(std::move(samples)),
+    m_numberOfChannels(numberOfChannels),
+    m_sampleRate(sampleRate)
+{
+
+}
+
+
+/**
+ * \brief Loads a WAV file.
+ *
+ * \return Whether the file could be read, the reason is printed if not
+ */
+bool WavFile::loadFromFile(const std::string& path)
+{
+    MappedWavReader reader;
+    if (!reader.open(path))
+        return false;
+
+    // decode straight from the mapped file, the raw bytes are never copied
+    m_numberOfChannels = reader.numberOfChannels();
+    m_sampleRate = reader.sampleRate();
+    m_samples.resize(reader.numberOfFrames() * m_numberOfChannels);
+    reader.readFrames(0, reader.numberOfFrames(), m_samples.data());
+
+    return true;
+}
+
+
+/**
+ * \brief Saves the samples as 16 bit PCM, samples outside of [-1, 1] are clipped.
+ *
+ * \return Whether the file could be written
+ */
+bool WavFile::saveToFile(const std::string& path) const
+{
+    MappedWavWriter writer;
+    if (!writer.open(path, m_numberOfChannels, m_sampleRate, numberOfFrames()))
+        return false;
+
+    writer.writeFrames(0, numberOfFrames(), m_samples.data());
+
+    return writer.close();
+}
+
+
+const std::vector<float>& WavFile::samples() const
+{
+    return m_samples;
+}
+
+
+std::size_t WavFile::numberOfChannels() const
+{
+    return m_numberOfChannels;
+}
+
+
+std::size_t WavFile::numberOfFrames() const
+{
+    return m_numberOfChannels == 0 ? 0 : m_samples.size() / m_numberOfChannels;
+}
+
+
+std::size_t WavFile::sampleRate() const
+{
+    return m_sampleRate;
+}
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef WAVFILE_HPP
+#define WAVFILE_HPP
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+/*
+ * \brief Reads and writes WAV files without depending on SFML.
+ *        Loads 16, 24 and 32 bit integer and 32 bit float PCM, saves 16 bit PCM.
+ *        The samples are interleaved floats in the range [-1, 1].
+ *        Files are read and written through a MappedWavReader and MappedWavWriter.
+ */
+
+class WavFile
+{
+public:
+    WavFile();
+    WavFile(std::vector<float> samples, std::size_t numberOfChannels, std::size_t sampleRate);
+
+    bool loadFromFile(const std::string& path);
+    bool saveToFile(const std::string& path) const;
+
+    const std::vector<float>& samples() const;
+    std::size_t               numberOfChannels() const;
+    std::size_t               numberOfFrames() const;
+    std::size_t               sampleRate() const;
+
+
+private:
+    std::vector<float> m_samples;
+    std::size_t        m_numberOfChannels;
+    std::size_t        m_sampleRate;
+};
+
+
+#endif // WAVFILE_HPP
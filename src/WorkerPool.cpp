@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+
+namespace
+{
+    // the pool and deque of the current thread, if it is a worker
+    thread_local const void*  t_pool = nullptr;
+    thread_local std::size_t  t_thread = 0;
+
+    // the job of the task the current thread is running, the parent of the jobs it starts
+    thread_local const void*  t_job = nullptr;
+}
+
+
+/**
+ * \param numberOfThreads How many threads work on a job including the caller of run(), 0 uses every core
+ */
+WorkerPool::WorkerPool(std::size_t numberOfThreads) :
+    m_queuedTasks(0),
+    m_pushes(0),
+    m_running(true)
+{
+    if (numberOfThreads == 0)
+        numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (std::size_t i = 0; i < numberOfThreads; ++i)
+    {
+        m_deques.push_back(std::make_unique<Deque>());
+        m_deques.back()->first = 0;
+        m_deques.back()->size = 0;
+    }
+
+    for (std::size_t i = 1; i < numberOfThreads; ++i)
+        m_threads.emplace_back(&WorkerPool::workerLoop, this, i);
+}
+
+
+/**
+ * \brief No run() may be active any more.
+ */
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wakeUp.notify_all();
+
+    for (auto& thread: m_threads)
+        thread.join();
+}
+
+
+/**
+ * \brief Calls task(i) for every i in [0, numberOfTasks), spread over all threads.
+ *        Returns when every task is done. While it waits, the caller runs the tasks of this job
+ *        and of the jobs nested in it, so a task may call run() itself without blocking a thread.
+ *        It leaves unrelated tasks to the other threads, which would pile their stacks onto this one.
+ */
+void WorkerPool::run(std::size_t numberOfTasks, const std::function<void(std::size_t)>& task)
+{
+    if (numberOfTasks == 0)
+        return;
+
+    const std::size_t thread = callingThread();
+
+    Job job;
+    job.task = &task;
+    job.remaining = numberOfTasks;
+    job.parent = static_cast<const Job*>(t_job);
+
+    // counted first, so the count never drops below the tasks that can be taken
+    m_queuedTasks += numberOfTasks;
+
+    {
+        Deque& deque = *m_deques[thread];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+
+        if (deque.tasks.size() < deque.size + numberOfTasks)
+        {
+            // unwrap the ring into a larger one
+            std::vector<Task> tasks(std::max(2 * deque.tasks.size(), deque.size + numberOfTasks));
+            for (std::size_t i = 0; i < deque.size; ++i)
+                tasks[i] = deque.tasks[(deque.first + i) % deque.tasks.size()];
+            deque.tasks.swap(tasks);
+            deque.first = 0;
+        }
+
+        // the owner takes the newest task first, so the tasks are pushed backwards to run in order
+        for (std::size_t i = numberOfTasks; i-- > 0; )
+            deque.tasks[(deque.first + deque.size++) % deque.tasks.size()] = Task{ &job, i };
+    }
+
+    ++m_pushes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_wakeUp.notify_all();
+
+    while (job.remaining > 0)
+    {
+        // read before searching, a nested job pushed during the search changes it
+        const std::size_t pushes = m_pushes;
+        if (runTask(thread, &job))
+            continue;
+
+        // the last tasks of the job run on other threads, sleep until they are done or one of them starts a nested job
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeUp.wait(lock, [&] { return job.remaining == 0 || m_pushes != pushes; });
+    }
+}
+
+
+std::size_t WorkerPool::numberOfThreads() const
+{
+    return m_threads.size() + 1;
+}
+
+
+void WorkerPool::workerLoop(std::size_t thread)
+{
+    t_pool = this;
+    t_thread = thread;
+
+    while (true)
+    {
+        if (runTask(thread, nullptr))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeUp.wait(lock, [this] { return !m_running || m_queuedTasks > 0; });
+        if (!m_running)
+            return;
+    }
+}
+
+
+/**
+ * \brief Runs the newest task of the threads own deque or else the oldest one of another.
+ *        A thread waiting for a job only runs the newest task of it or of a job nested in it.
+ *
+ * \param waitingFor The job the thread waits for or nullptr for an idle worker
+ * \return Whether there was a task
+ */
+bool WorkerPool::runTask(std::size_t thread, const Job* waitingFor)
+{
+    Task task;
+    bool found = false;
+
+    if (waitingFor)
+    {
+        for (std::size_t i = 0; !found && i < m_deques.size(); ++i)
+            found = takeNested(*m_deques[(thread + i) % m_deques.size()], *waitingFor, task);
+    }
+    else
+    {
+        found = takeNewest(*m_deques[thread], task);
+
+        for (std::size_t i = 1; !found && i < m_deques.size(); ++i)
+            found = takeOldest(*m_deques[(thread + i) % m_deques.size()], task);
+    }
+
+    if (!found)
+        return false;
+
+    --m_queuedTasks;
+
+    Job& job = *task.job;
+
+    const void* const outerJob = t_job;
+    t_job = &job;
+    (*job.task)(task.index);
+    t_job = outerJob;
+
+    // the job belongs to the stack of its run() call, it may be gone right after the last decrement
+    if (--job.remaining == 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_wakeUp.notify_all();
+    }
+
+    return true;
+}
+
+
+bool WorkerPool::takeNewest(Deque& deque, Task& task)
+{
+    std::lock_guard<std::mutex> lock(deque.mutex);
+    if (deque.size == 0)
+        return false;
+
+    task = deque.tasks[(deque.first + --deque.size) % deque.tasks.size()];
+    return true;
+}
+
+
+bool WorkerPool::takeOldest(Deque& deque, Task& task)
+{
+    std::lock_guard<std::mutex> lock(deque.mutex);
+    if (deque.size == 0)
+        return false;
+
+    task = deque.tasks[deque.first];
+    deque.first = (deque.first + 1) % deque.tasks.size();
+    --deque.size;
+    return true;
+}
+
+
+/**
+ * \brief Takes the newest task of job or of a job nested in it out of the deque.
+ *        The nested tasks were pushed last, so the search starts at the newest end and the
+ *        newer tasks move down to close the gap.
+ */
+bool WorkerPool::takeNested(Deque& deque, const Job& job, Task& task)
+{
+    std::lock_guard<std::mutex> lock(deque.mutex);
+
+    for (std::size_t i = deque.size; i-- > 0; )
+    {
+        const Task& candidate = deque.tasks[(deque.first + i) % deque.tasks.size()];
+
+        // every job up the chain waits in a run() call, so the parents are alive
+        const Job* ancestor = candidate.job;
+        while (ancestor && ancestor != &job)
+            ancestor = ancestor->parent;
+
+        if (!ancestor)
+            continue;
+
+        task = candidate;
+        for (std::size_t j = i + 1; j < deque.size; ++j)
+            deque.tasks[(deque.first + j - 1) % deque.tasks.size()] = deque.tasks[(deque.first + j) % deque.tasks.size()];
+        --deque.size;
+        return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * \brief The deque of the calling thread, threads outside of the pool share the first one.
+ */
+std::size_t WorkerPool::callingThread() const
+{
+    return t_pool == this ? t_thread : 0;
+}
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/*
+ * \brief A fixed set of threads that run numbered tasks in parallel.
+ *        The threads are started once and sleep while there is nothing to do.
+ *        Every thread has its own deque of tasks: it takes the newest task from its own and,
+ *        when that is empty, steals the oldest task of another thread. run() may be called
+ *        from several threads at once and from inside a task, the nested tasks go into the
+ *        deque of the calling worker and idle threads steal them. A caller of run() works on
+ *        the tasks of its own job and of the jobs nested in it, but never on unrelated ones,
+ *        so the stack of a waiting thread only grows with the nesting, and returns when all of
+ *        its tasks are done.
+ */
+
+class WorkerPool
+{
+public:
+    WorkerPool(std::size_t numberOfThreads = 0);
+    ~WorkerPool();
+
+    void        run(std::size_t numberOfTasks, const std::function<void(std::size_t)>& task);
+    std::size_t numberOfThreads() const;
+
+
+private:
+    // the tasks of one run() call
+    struct Job
+    {
+        const std::function<void(std::size_t)>*  task;
+        std::atomic<std::size_t>                 remaining;
+        const Job*                               parent;    // the job whose task called run(), if any
+    };
+
+    struct Task
+    {
+        Job*        job;
+        std::size_t index;
+    };
+
+    // a ring buffer, it only allocates when it grows beyond every earlier size
+    struct Deque
+    {
+        std::mutex         mutex;
+        std::vector<Task>  tasks;
+        std::size_t        first;
+        std::size_t        size;
+    };
+
+    void workerLoop(std::size_t thread);
+    bool runTask(std::size_t thread, const Job* waitingFor);
+    bool takeNewest(Deque& deque, Task& task);
+    bool takeOldest(Deque& deque, Task& task);
+    bool takeNested(Deque& deque, const Job& job, Task& task);
+    std::size_t callingThread() const;
+
+    std::vector<std::thread>                    m_threads;
+    std::vector<std::unique_ptr<Deque>>         m_deques;          // 0 is shared by all threads outside the pool
+    std::mutex                                  m_mutex;
+    std::condition_variable                     m_wakeUp;
+    std::atomic<std::size_t>                    m_queuedTasks;
+    std::atomic<std::size_t>                    m_pushes;          // counts the run() calls, a waiter without a task sleeps until it changes
+    bool                                        m_running;
+};
+
+
+#endif // WORKERPOOL_HPP
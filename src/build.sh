@@ -1,3 +1,5 @@
 #!/bin/sh
 
-g++ -std=c++11 -O3 MagnitudeSpectrum.cpp SineWaveSpeech.cpp CaptainJack.cpp -ljackcpp -ljack -lfftw3f -o sineWaveSpeech
+g++ -std=c++14 -O3 MagnitudeSpectrum.cpp PCM.cpp OscillatorTable.cpp SpectralSynthesizer.cpp SineWaveScore.cpp SineWaveSpeech.cpp MultichannelSineWaveSpeech.cpp AsyncProcessor.cpp LiveEngine.cpp NullAudioHost.cpp MappedWav.cpp WavFile.cpp Telemetry.cpp WorkerPool.cpp StreamEngine.cpp CaptainJack.cpp -pthread -ljackcpp -ljack -lfftw3f -o sineWaveSpeech
+g++ -std=c++14 -O3 MagnitudeSpectrum.cpp PCM.cpp OscillatorTable.cpp SpectralSynthesizer.cpp SineWaveScore.cpp SineWaveSpeech.cpp MultichannelSineWaveSpeech.cpp Telemetry.cpp WorkerPool.cpp SocketServer.cpp SineWaveSpeechDaemon.cpp -pthread -o sineWaveSpeechDaemon
+g++ -std=c++14 -O3 MagnitudeSpectrum.cpp PCM.cpp OscillatorTable.cpp SpectralSynthesizer.cpp SineWaveScore.cpp SineWaveSpeech.cpp MultichannelSineWaveSpeech.cpp Telemetry.cpp WorkerPool.cpp AnalysisCache.cpp MappedWav.cpp StreamingConverter.cpp WavFile.cpp BatchConverter.cpp -pthread -o sineWaveSpeechBatch
@@ -25,7 +25,8 @@
 #include <iomanip>
 #include <algorithm>
 
-#include "SineWaveSpeech.hpp"
+#include "MultichannelSineWaveSpeech.hpp"
+#include "PCM.hpp"
 #include "ResourcePath.hpp"
 
 int main(int, char const**)
@@ -41,41 +42,29 @@ int main(int, char const**)
         std::cerr << "Could not load \"Hello.wav\" sound." << std::endl;
         return EXIT_FAILURE;
     }
-    if (originalSoundBuffer.getChannelCount() > 1)
-    {
-        // TODO: Implement stereo support
-        std::cerr << "Loaded sound has to be mono (1 channel)." << std::endl;
-        return EXIT_FAILURE;
-    }
     sf::Sound originalSound(originalSoundBuffer);
     
     const size_t FFTSize = 512;
     const unsigned int sampleRate = originalSoundBuffer.getSampleRate();
-    SineWaveSpeech sineWaveSpeech(FFTSize, true);
+    const unsigned int channelCount = originalSoundBuffer.getChannelCount();
+    MultichannelSineWaveSpeech sineWaveSpeech(channelCount, FFTSize, FFTSize / 2, 50, true);
     sineWaveSpeech.nextToneGenerator();
     
-    // get the samples as ints
-    std::vector<sf::Int16> rawSamples(originalSoundBuffer.getSamples(), originalSoundBuffer.getSamples() + originalSoundBuffer.getSampleCount());
-    
-    // transform int samples into normalized float samples
-    std::vector<float> samples(rawSamples.size());
-    std::transform(rawSamples.begin(), rawSamples.end(), samples.begin(),
-                   [](float sample)
-                   {
-                       return sample / 32767.f;
-                   });
+    // the int samples of the buffer are analysed as they are, read as n / 32768 and written as n * 32767
+    // like the WAV files of the other tools, so the output is 32767/32768 of the input scale
+    const sf::Int16* firstSample = originalSoundBuffer.getSamples();
+    std::vector<std::int16_t> samples(firstSample, firstSample + originalSoundBuffer.getSampleCount());
     
-    std::vector<float> outputSamples = sineWaveSpeech.generateSineWaveSpeech(samples, sampleRate);
+    // every channel is synthesized on its own, in parallel
+    std::vector<float> outputSamples = sineWaveSpeech.generateSineWaveSpeech(samples, MultichannelSineWaveSpeech::Layout::Interleaved, sampleRate);
     
-    std::transform(outputSamples.begin(), outputSamples.end(), rawSamples.begin(),
-                   [](float sample)
-                   {
-                       return sample * 32767.f;
-                   });
+    // the output is zero padded to whole frames, so it can be longer than the input
+    std::vector<sf::Int16> rawSamples(outputSamples.size());
+    PCM::floatToInt16(outputSamples.data(), rawSamples.data(), rawSamples.size());
     
     // load the generated sinus sound
     sf::SoundBuffer sinusSoundBuffer;
-    if (!sinusSoundBuffer.loadFromSamples(rawSamples.data(), rawSamples.size(), 1, sampleRate)) {
+    if (!sinusSoundBuffer.loadFromSamples(rawSamples.data(), rawSamples.size(), channelCount, sampleRate)) {
         std::cerr << "Could not load sinus sound." << std::endl;
         return EXIT_FAILURE;
     }
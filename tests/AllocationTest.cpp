@@ -0,0 +1,436 @@
+////////////////////////////////////////////////////////////
+//
+// SineWaveSpeech - A sine wave speech synthesizer
+// Copyright (C) 2017  Maximilian Wagenbach
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////
+
+// Streams a signal through SineWaveSpeech::processBlock() and MultichannelSineWaveSpeech::processInterleaved()
+// with every tone generator, both syntheses, several hops and odd block sizes and fails if any of the
+// calls allocates or frees memory. malloc, calloc, realloc, free, posix_memalign and aligned_alloc are
+// replaced by counting versions that forward to the C library, and every operator new and delete goes through them.
+
+#include "SineWaveSpeech.hpp"
+#include "MultichannelSineWaveSpeech.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include <dlfcn.h>
+
+
+namespace
+{
+    bool        s_counting = false;
+    std::size_t s_allocations = 0;
+
+    void count(const void* memory)
+    {
+        if (s_counting && memory)
+            ++s_allocations;
+    }
+
+    // the functions of the C library, looked up on the first call
+    typedef void* (*Malloc)(std::size_t);
+    typedef void* (*Calloc)(std::size_t, std::size_t);
+    typedef void* (*Realloc)(void*, std::size_t);
+    typedef void  (*Free)(void*);
+    typedef int   (*PosixMemalign)(void**, std::size_t, std::size_t);
+    typedef void* (*AlignedAlloc)(std::size_t, std::size_t);
+
+    Malloc        s_malloc = nullptr;
+    Calloc        s_calloc = nullptr;
+    Realloc       s_realloc = nullptr;
+    Free          s_free = nullptr;
+    PosixMemalign s_posixMemalign = nullptr;
+    AlignedAlloc  s_alignedAlloc = nullptr;
+
+    // dlsym() may allocate while the functions are looked up, that is served from here and never freed
+    alignas(std::max_align_t) char s_bootstrap[4096];
+    std::size_t                    s_bootstrapUsed = 0;
+    bool                           s_resolving = false;
+
+    void* bootstrapAllocate(std::size_t size)
+    {
+        const std::size_t alignment = alignof(std::max_align_t);
+        size = (size + alignment - 1) / alignment * alignment;
+        if (s_bootstrapUsed + size > sizeof(s_bootstrap))
+            return nullptr;
+
+        void* memory = s_bootstrap + s_bootstrapUsed;
+        s_bootstrapUsed += size;
+        return memory;
+    }
+
+    bool isBootstrap(const void* memory)
+    {
+        return memory >= s_bootstrap && memory < s_bootstrap + sizeof(s_bootstrap);
+    }
+
+    void resolve()
+    {
+        if (s_free)
+            return;
+
+        s_resolving = true;
+        s_malloc = reinterpret_cast<Malloc>(dlsym(RTLD_NEXT, "malloc"));
+        s_calloc = reinterpret_cast<Calloc>(dlsym(RTLD_NEXT, "calloc"));
+        s_realloc = reinterpret_cast<Realloc>(dlsym(RTLD_NEXT, "realloc"));
+        s_posixMemalign = reinterpret_cast<PosixMemalign>(dlsym(RTLD_NEXT, "posix_memalign"));
+        s_alignedAlloc = reinterpret_cast<AlignedAlloc>(dlsym(RTLD_NEXT, "aligned_alloc"));
+        s_free = reinterpret_cast<Free>(dlsym(RTLD_NEXT, "free"));
+        s_resolving = false;
+
+        if (!s_malloc || !s_calloc || !s_realloc || !s_posixMemalign || !s_alignedAlloc || !s_free)
+        {
+            std::fputs("Could not find the allocation functions of the C library.\n", stderr);
+            std::abort();
+        }
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        void* memory = nullptr;
+        if (alignment <= alignof(std::max_align_t))
+            memory = std::malloc(size ? size : 1);
+        else if (posix_memalign(&memory, alignment, size ? size : 1) != 0)
+            memory = nullptr;
+        return memory;
+    }
+
+    const std::size_t sampleRate = 44100;
+    const std::size_t FFTSize = 512;
+    const std::size_t numberOfChannels = 2;
+
+    std::vector<float> testSignal(std::size_t length)
+    {
+        std::vector<float> samples(length);
+        for (std::size_t i = 0; i < length; ++i)
+            samples[i] = 0.5f * std::sin(0.01f * i * (1.f + i / 100000.f)) + 0.1f * std::sin(0.37f * i);
+        return samples;
+    }
+
+    // counts the allocations of processing signal in blocks of blockSize samples per channel
+    template<typename Process>
+    std::size_t countAllocations(const std::vector<float>& signal, std::vector<float>& output, std::size_t channels,
+                                 std::size_t blockSize, Process process)
+    {
+        s_allocations = 0;
+        s_counting = true;
+
+        const std::size_t length = signal.size() / channels;
+        for (std::size_t start = 0; start < length; start += blockSize)
+        {
+            const std::size_t n = std::min(blockSize, length - start);
+            process(signal.data() + start * channels, output.data() + start * channels, n);
+        }
+
+        s_counting = false;
+        return s_allocations;
+    }
+}
+
+
+extern "C" void* malloc(std::size_t size) noexcept
+{
+    if (s_resolving)
+        return bootstrapAllocate(size);
+    resolve();
+
+    void* memory = s_malloc(size);
+    count(memory);
+    return memory;
+}
+
+
+extern "C" void* calloc(std::size_t number, std::size_t size) noexcept
+{
+    // dlsym() asks for zeroed memory, the bootstrap buffer is never reused, so it still is
+    if (s_resolving)
+        return bootstrapAllocate(number * size);
+    resolve();
+
+    void* memory = s_calloc(number, size);
+    count(memory);
+    return memory;
+}
+
+
+extern "C" void* realloc(void* memory, std::size_t size) noexcept
+{
+    resolve();
+
+    if (isBootstrap(memory))
+    {
+        void* moved = malloc(size);
+        if (moved)
+            std::memcpy(moved, memory, std::min<std::size_t>(size, s_bootstrap + sizeof(s_bootstrap) - static_cast<char*>(memory)));
+        return moved;
+    }
+
+    void* reallocated = s_realloc(memory, size);
+    count(reallocated);
+    return reallocated;
+}
+
+
+extern "C" void free(void* memory) noexcept
+{
+    if (isBootstrap(memory))
+        return;
+    resolve();
+
+    count(memory);
+    s_free(memory);
+}
+
+
+extern "C" int posix_memalign(void** memory, std::size_t alignment, std::size_t size) noexcept
+{
+    resolve();
+
+    const int result = s_posixMemalign(memory, alignment, size);
+    if (result == 0)
+        count(*memory);
+    return result;
+}
+
+
+extern "C" void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+    resolve();
+
+    void* memory = s_alignedAlloc(alignment, size);
+    count(memory);
+    return memory;
+}
+
+
+// every form of operator new and delete is counted by the functions above
+
+void* operator new(std::size_t size)
+{
+    void* memory = allocate(size, 0);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, 0);
+}
+
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, 0);
+}
+
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    void* memory = allocate(size, static_cast<std::size_t>(alignment));
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+
+
+
+int main()
+{
+    // a replacement the linker didn't pick up would let every configuration pass
+    s_allocations = 0;
+    s_counting = true;
+    void* volatile memory = std::malloc(16);
+    std::free(memory);
+    int* volatile number = new int;
+    delete number;
+    s_counting = false;
+    if (s_allocations != 4)
+    {
+        std::cerr << "The allocation functions are not replaced, counted " << s_allocations << " of 4 calls." << std::endl;
+        return 1;
+    }
+
+    const std::vector<float> mono = testSignal(sampleRate);
+
+    std::vector<float> interleaved(mono.size() * numberOfChannels);
+    for (std::size_t i = 0; i < mono.size(); ++i)
+        for (std::size_t c = 0; c < numberOfChannels; ++c)
+            interleaved[i * numberOfChannels + c] = mono[(i + c * 1000) % mono.size()];
+
+    std::vector<float> output(interleaved.size());
+
+    const SineWaveSpeech::Synthesis syntheses[] = { SineWaveSpeech::Synthesis::ToneGenerator, SineWaveSpeech::Synthesis::InverseFFT };
+    const std::size_t hopSizes[] = { FFTSize / 8, FFTSize / 4, FFTSize / 2, FFTSize };
+    const std::size_t blockSizes[] = { 1, 37, 64, 331, 1021 };
+
+    std::size_t failures = 0;
+
+    for (auto synthesis: syntheses)
+    {
+        for (std::size_t toneGenerator = 0; toneGenerator < 3; ++toneGenerator)
+        {
+            for (auto hopSize: hopSizes)
+            {
+                SineWaveSpeech::Parameters parameters = { 3000.f, std::sqrt(2.f), 50, static_cast<unsigned int>(toneGenerator), synthesis };
+
+                for (auto blockSize: blockSizes)
+                {
+                    SineWaveSpeech sineWaveSpeech(FFTSize, hopSize, 50, false);
+                    sineWaveSpeech.parameters(parameters);
+                    sineWaveSpeech.sampleRate(sampleRate);
+
+                    MultichannelSineWaveSpeech multichannel(numberOfChannels, FFTSize, hopSize, 50, false);
+                    multichannel.parameters(parameters);
+                    multichannel.sampleRate(sampleRate);
+
+                    const std::size_t single = countAllocations(mono, output, 1, blockSize, [&](const float* in, float* out, std::size_t n)
+                                                                {
+                                                                    sineWaveSpeech.processBlock(in, out, n);
+                                                                });
+                    const std::size_t multiple = countAllocations(interleaved, output, numberOfChannels, blockSize, [&](const float* in, float* out, std::size_t n)
+                                                                  {
+                                                                      multichannel.processInterleaved(in, out, n);
+                                                                  });
+
+                    if (single + multiple > 0)
+                    {
+                        std::cerr << "synthesis " << (synthesis == SineWaveSpeech::Synthesis::InverseFFT ? "ifft" : "tone")
+                                  << ", tone generator " << toneGenerator << ", hop " << hopSize << ", block " << blockSize << ": "
+                                  << single << " allocations in processBlock(), "
+                                  << multiple << " in processInterleaved()" << std::endl;
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " configurations allocated memory while processing." << std::endl;
+        return 1;
+    }
+
+    std::cout << "No allocations while processing." << std::endl;
+    return 0;
+}